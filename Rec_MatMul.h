@@ -1,8 +1,17 @@
+#pragma once
+
 #include <vector>
+#include <deque>
 #include <algorithm>
+#include <functional>
+#include <stdexcept>
 #include "cache_size.h"
+#include "cpu_topology.h"
+#include "semiring.h"
+#include "worker_pool.h"
 #include <cmath>
 #include <thread>
+#include <atomic>
 
 const int BLOCK_SIZE = sqrt((getL1CacheSize()*1024)/12);
 
@@ -11,47 +20,111 @@ struct Mat {
     std::vector<int> matrix;
     Mat(int r, int c) : rows(r), cols(c), matrix(r * c, 0) {}
 };
+
+// Read-only, non-owning view of a row-major matrix with contiguous rows.
+// Kernels take their operands as views, so both a Mat and memory mapped
+// from a file can be multiplied without copying.
+struct MatView {
+    int rows, cols;
+    const int* matrix;
+    MatView(int r, int c, const int* data) : rows(r), cols(c), matrix(data) {}
+    MatView(const Mat& m) : rows(m.rows), cols(m.cols), matrix(m.matrix.data()) {}
+};
+
+// What a multiply into an existing result does with the values already there
+enum class Update { Overwrite, Accumulate };
+
+// Scratch kept across calls of the into-result multiplies: the K-split partial buffers of
+// BlockedMul_threading and the quadrant temporaries of matMul are reshaped and reused instead
+// of being allocated on every call
+struct MulWorkspace {
+    std::vector<Mat> partials;
+    std::deque<Mat> quadrants;  // two per recursion depth; a deque, so growing keeps the others in place
+};
+
 namespace MatMath {
 
+    using Semiring::PlusTimes;
+
+    // Result matrix with every element set to the semiring's additive identity
+    template <class S = PlusTimes>
+    Mat semiringZeros(int rows, int cols) {
+        Mat result(rows, cols);
+        if (S::zero() != 0) std::fill(result.matrix.begin(), result.matrix.end(), S::zero());
+        return result;
+    }
+
+    // Reuse a matrix's storage for a rows x cols result; it only reallocates when it has to grow
+    Mat reshapeMat(Mat&& storage, int rows, int cols) {
+        Mat result = std::move(storage);
+        result.rows = rows;
+        result.cols = cols;
+        result.matrix.resize(size_t(rows) * cols);
+        return result;
+    }
+
+    // A result passed in must have the product's shape and must not share memory with an operand
+    void checkResult(MatView mat1, MatView mat2, const Mat& result) {
+        if (mat1.cols != mat2.rows || result.rows != mat1.rows || result.cols != mat2.cols) {
+            throw std::invalid_argument("result shape does not match the product");
+        }
+        auto overlaps = [&](MatView operand) {
+            const int* begin = result.matrix.data();
+            const int* end = begin + result.matrix.size();
+            const int* op_end = operand.matrix + size_t(operand.rows) * operand.cols;
+            return std::less<const int*>()(operand.matrix, end) && std::less<const int*>()(begin, op_end);
+        };
+        if (overlaps(mat1) || overlaps(mat2)) throw std::invalid_argument("result aliases an operand");
+    }
+
     // Standard multiplication with direct access
-    void MultiplyMat(Mat& result, const Mat& mat1, const Mat& mat2,
+    template <class S = PlusTimes>
+    void MultiplyMat(Mat& result, MatView mat1, MatView mat2,
                      int r1_start, int r1_end, int c1_start, int c1_end,
                      int r2_start, int r2_end, int c2_start, int c2_end,
-                     int r_res_start, int c_res_start) {
+                     int r_res_start, int c_res_start, bool accumulate = false) {
         int r_size = r1_end - r1_start;
         int c_size = c2_end - c2_start;
         for (int i = 0; i < r_size && r_res_start + i < result.rows; i++) {
             for (int j = 0; j < c_size && c_res_start + j < result.cols; j++) {
-                int sum = 0;
+                using Acc = Semiring::Accumulator<S>;
+                typename Acc::type sum = Acc::zero();
                 for (int k = c1_start; k < c1_end; k++) {
-                    sum += mat1.matrix[(r1_start + i) * mat1.cols + k] * 
-                           mat2.matrix[k * mat2.cols + (c2_start + j)];
+                    sum = Acc::step(sum, mat1.matrix[(r1_start + i) * mat1.cols + k],
+                                         mat2.matrix[k * mat2.cols + (c2_start + j)]);
                 }
-                result.matrix[(r_res_start + i) * result.cols + (c_res_start + j)] = sum;
+                int& c = result.matrix[(r_res_start + i) * result.cols + (c_res_start + j)];
+                c = accumulate ? S::add(c, Acc::finish(sum)) : Acc::finish(sum);
             }
         }
     }
 
-    // Add matrices in-place with direct access
-    void add(Mat& result, const Mat& mat1, const Mat& mat2,
+    // Add matrices in-place with direct access (onto the result's values when accumulating)
+    template <class S = PlusTimes>
+    void add(Mat& result, MatView mat1, MatView mat2,
              int r_start, int r_end, int c_start, int c_end,
-             int r_res_start, int c_res_start) {
+             int r_res_start, int c_res_start, bool accumulate = false) {
         int r_size = r_end - r_start;
         int c_size = c_end - c_start;
         for (int i = 0; i < r_size && r_res_start + i < result.rows; i++) {
             for (int j = 0; j < c_size && c_res_start + j < result.cols; j++) {
-                result.matrix[(r_res_start + i) * result.cols + (c_res_start + j)] = 
-                    mat1.matrix[(r_start + i) * mat1.cols + (c_start + j)] + 
-                    mat2.matrix[(r_start + i) * mat2.cols + (c_start + j)];
+                int sum = S::add(mat1.matrix[(r_start + i) * mat1.cols + (c_start + j)],
+                                 mat2.matrix[(r_start + i) * mat2.cols + (c_start + j)]);
+                int& c = result.matrix[(r_res_start + i) * result.cols + (c_res_start + j)];
+                c = accumulate ? S::add(c, sum) : sum;
             }
         }
     }
 
-    // Recursive multiplication without copying
-    void matMul(Mat& result, const Mat& mat1, const Mat& mat2,
+    // Recursive multiplication without copying. With `accumulate` the product is added onto the
+    // result's region instead of replacing it; the quadrant temporaries are always overwritten.
+    // They are taken from the workspace when one is given, else from one local to this call.
+    template <class S = PlusTimes>
+    void matMul(Mat& result, MatView mat1, MatView mat2,
                 int r1_start, int r1_end, int c1_start, int c1_end,
                 int r2_start, int r2_end, int c2_start, int c2_end,
-                int r_res_start, int c_res_start) {
+                int r_res_start, int c_res_start, bool accumulate = false,
+                MulWorkspace* workspace = nullptr, int depth = 0) {
         int r1_size = r1_end - r1_start;
         int c1_size = c1_end - c1_start; // Also mat2 rows
         int c2_size = c2_end - c2_start;
@@ -65,10 +138,10 @@ namespace MatMath {
         // Base case
         if (r1_size <= 64 || c1_size <= 64 || c2_size <= 64 || 
             r1_size <= 0 || c1_size <= 0 || c2_size <= 0) {
-            MultiplyMat(result, mat1, mat2,
+            MultiplyMat<S>(result, mat1, mat2,
                         r1_start, r1_end, c1_start, c1_end,
                         r2_start, r2_end, c2_start, c2_end,
-                        r_res_start, c_res_start);
+                        r_res_start, c_res_start, accumulate);
             return;
         }
 
@@ -81,95 +154,338 @@ namespace MatMath {
         mid2 = (std::min)(mid2, mat1.cols);
         mid3 = (std::min)(mid3, mat2.cols);
 
-        // Temporary buffers sized to submatrix dimensions
+        if (!workspace) {
+            MulWorkspace local;
+            matMul<S>(result, mat1, mat2, r1_start, r1_end, c1_start, c1_end, r2_start, r2_end, c2_start, c2_end,
+                      r_res_start, c_res_start, accumulate, &local, depth);
+            return;
+        }
+
+        // Temporary buffers sized to submatrix dimensions, this depth's pair of the workspace
+        MulWorkspace& scratch = *workspace;
+        if (scratch.quadrants.size() < size_t(2 * depth + 2)) scratch.quadrants.resize(2 * depth + 2, Mat(0, 0));
+        Mat& temp1 = scratch.quadrants[2 * depth];
+        Mat& temp2 = scratch.quadrants[2 * depth + 1];
+        auto quadrant = [&](int rows, int cols) {
+            temp1 = reshapeMat(std::move(temp1), rows, cols);
+            temp2 = reshapeMat(std::move(temp2), rows, cols);
+        };
         int temp_r_size = mid1 - r1_start; // Top-left rows
         int temp_c_size = mid3 - c2_start; // Top-left cols
-        Mat temp1(temp_r_size, temp_c_size);
-        Mat temp2(temp_r_size, temp_c_size);
+        quadrant(temp_r_size, temp_c_size);
 
         // Top-left: C11 = A11*B11 + A12*B21
-        matMul(temp1, mat1, mat2, r1_start, mid1, c1_start, mid2, r2_start, mid2, c2_start, mid3, 0, 0);
-        matMul(temp2, mat1, mat2, r1_start, mid1, mid2, c1_end, mid2, r2_end, c2_start, mid3, 0, 0);
-        add(result, temp1, temp2, 0, temp_r_size, 0, temp_c_size, r_res_start, c_res_start);
+        matMul<S>(temp1, mat1, mat2, r1_start, mid1, c1_start, mid2, r2_start, mid2, c2_start, mid3, 0, 0, false, &scratch, depth + 1);
+        matMul<S>(temp2, mat1, mat2, r1_start, mid1, mid2, c1_end, mid2, r2_end, c2_start, mid3, 0, 0, false, &scratch, depth + 1);
+        add<S>(result, temp1, temp2, 0, temp_r_size, 0, temp_c_size, r_res_start, c_res_start, accumulate);
 
         // Top-right: C12 = A11*B12 + A12*B22
         int temp_c_size_right = c2_end - mid3;
-        temp1 = Mat(temp_r_size, temp_c_size_right);
-        temp2 = Mat(temp_r_size, temp_c_size_right);
-        matMul(temp1, mat1, mat2, r1_start, mid1, c1_start, mid2, r2_start, mid2, mid3, c2_end, 0, 0);
-        matMul(temp2, mat1, mat2, r1_start, mid1, mid2, c1_end, mid2, r2_end, mid3, c2_end, 0, 0);
-        add(result, temp1, temp2, 0, temp_r_size, 0, temp_c_size_right, r_res_start, c_res_start + temp_c_size);
+        quadrant(temp_r_size, temp_c_size_right);
+        matMul<S>(temp1, mat1, mat2, r1_start, mid1, c1_start, mid2, r2_start, mid2, mid3, c2_end, 0, 0, false, &scratch, depth + 1);
+        matMul<S>(temp2, mat1, mat2, r1_start, mid1, mid2, c1_end, mid2, r2_end, mid3, c2_end, 0, 0, false, &scratch, depth + 1);
+        add<S>(result, temp1, temp2, 0, temp_r_size, 0, temp_c_size_right, r_res_start, c_res_start + temp_c_size, accumulate);
 
         // Bottom-left: C21 = A21*B11 + A22*B21
         int temp_r_size_bottom = r1_end - mid1;
-        temp1 = Mat(temp_r_size_bottom, temp_c_size);
-        temp2 = Mat(temp_r_size_bottom, temp_c_size);
-        matMul(temp1, mat1, mat2, mid1, r1_end, c1_start, mid2, r2_start, mid2, c2_start, mid3, 0, 0);
-        matMul(temp2, mat1, mat2, mid1, r1_end, mid2, c1_end, mid2, r2_end, c2_start, mid3, 0, 0);
-        add(result, temp1, temp2, 0, temp_r_size_bottom, 0, temp_c_size, r_res_start + temp_r_size, c_res_start);
+        quadrant(temp_r_size_bottom, temp_c_size);
+        matMul<S>(temp1, mat1, mat2, mid1, r1_end, c1_start, mid2, r2_start, mid2, c2_start, mid3, 0, 0, false, &scratch, depth + 1);
+        matMul<S>(temp2, mat1, mat2, mid1, r1_end, mid2, c1_end, mid2, r2_end, c2_start, mid3, 0, 0, false, &scratch, depth + 1);
+        add<S>(result, temp1, temp2, 0, temp_r_size_bottom, 0, temp_c_size, r_res_start + temp_r_size, c_res_start, accumulate);
 
         // Bottom-right: C22 = A21*B12 + A22*B22
-        temp1 = Mat(temp_r_size_bottom, temp_c_size_right);
-        temp2 = Mat(temp_r_size_bottom, temp_c_size_right);
-        matMul(temp1, mat1, mat2, mid1, r1_end, c1_start, mid2, r2_start, mid2, mid3, c2_end, 0, 0);
-        matMul(temp2, mat1, mat2, mid1, r1_end, mid2, c1_end, mid2, r2_end, mid3, c2_end, 0, 0);
-        add(result, temp1, temp2, 0, temp_r_size_bottom, 0, temp_c_size_right, r_res_start + temp_r_size, c_res_start + temp_c_size);
+        quadrant(temp_r_size_bottom, temp_c_size_right);
+        matMul<S>(temp1, mat1, mat2, mid1, r1_end, c1_start, mid2, r2_start, mid2, mid3, c2_end, 0, 0, false, &scratch, depth + 1);
+        matMul<S>(temp2, mat1, mat2, mid1, r1_end, mid2, c1_end, mid2, r2_end, mid3, c2_end, 0, 0, false, &scratch, depth + 1);
+        add<S>(result, temp1, temp2, 0, temp_r_size_bottom, 0, temp_c_size_right, r_res_start + temp_r_size, c_res_start + temp_c_size, accumulate);
+    }
+
+    // Into an existing result of the product's shape. With a workspace the quadrant temporaries
+    // are kept there too, so repeated calls of one shape allocate nothing.
+    template <class S = PlusTimes>
+    void matMul(MatView mat1, MatView mat2, Mat& result, Update update = Update::Overwrite,
+                MulWorkspace* workspace = nullptr) {
+        checkResult(mat1, mat2, result);
+        matMul<S>(result, mat1, mat2, 0, mat1.rows, 0, mat1.cols, 0, mat2.rows, 0, mat2.cols, 0, 0,
+                  update == Update::Accumulate, workspace);
     }
 
     // Wrapper
-    Mat matMul(const Mat& mat1, const Mat& mat2) {
+    template <class S = PlusTimes>
+    Mat matMul(MatView mat1, MatView mat2) {
         Mat result(mat1.rows, mat2.cols);
-        matMul(result, mat1, mat2, 0, mat1.rows, 0, mat1.cols, 0, mat2.rows, 0, mat2.cols, 0, 0);
+        matMul<S>(result, mat1, mat2, 0, mat1.rows, 0, mat1.cols, 0, mat2.rows, 0, mat2.cols, 0, 0);
         return result;
     }
 
-    
-    Mat BlockedMul(const Mat& mat1, const Mat& mat2){
-        Mat result(mat1.rows, mat2.cols);
-        
+    // Into recycled storage (c = matMul(a, b, std::move(c))), reshaped to the product
+    template <class S = PlusTimes>
+    Mat matMul(MatView mat1, MatView mat2, Mat&& storage, MulWorkspace* workspace = nullptr) {
+        Mat result = reshapeMat(std::move(storage), mat1.rows, mat2.cols);
+        matMul<S>(mat1, mat2, result, Update::Overwrite, workspace);
+        return result;
+    }
+
+
+    // Inner kernel of the blocked schedule: C[i0:i1, j0:j1] = add(C, A[i0:i1, k0:k1] * B[k0:k1, j0:j1])
+    template <class S>
+    struct TileKernel {
+        static void run(MatView mat1, MatView mat2, Mat& result, int i0, int i1, int j0, int j1, int k0, int k1) {
+            using Acc = Semiring::Accumulator<S>;
+            for (int ii = i0; ii < i1; ii++) {
+                for (int jj = j0; jj < j1; jj++) {
+                    typename Acc::type sum = Acc::zero();
+                    for (int kk = k0; kk < k1; kk++) {
+                        sum = Acc::step(sum, mat1.matrix[ii * mat1.cols + kk], mat2.matrix[kk * mat2.cols + jj]);
+                    }
+                    result.matrix[ii * result.cols + jj] = S::add(result.matrix[ii * result.cols + jj], Acc::finish(sum));
+                }
+            }
+        }
+    };
+
+    // i-k-j order: every inner step is C[ii, :] = add(C[ii, :], mul(a, B[kk, :])) over unit-stride rows,
+    // which vectorizes to packed min/max/add or and/or for the semirings specialized below
+    template <class S>
+    struct RowUpdateKernel {
+        static void run(MatView mat1, MatView mat2, Mat& result, int i0, int i1, int j0, int j1, int k0, int k1) {
+            for (int ii = i0; ii < i1; ii++) {
+                int* c_row = result.matrix.data() + ii * result.cols;
+                for (int kk = k0; kk < k1; kk++) {
+                    const int a = mat1.matrix[ii * mat1.cols + kk];
+                    const int* b_row = mat2.matrix + kk * mat2.cols;
+                    for (int jj = j0; jj < j1; jj++) {
+                        c_row[jj] = S::add(c_row[jj], S::mul(a, b_row[jj]));
+                    }
+                }
+            }
+        }
+    };
+
+    template <> struct TileKernel<Semiring::MinPlus> : RowUpdateKernel<Semiring::MinPlus> {};
+    template <> struct TileKernel<Semiring::MaxPlus> : RowUpdateKernel<Semiring::MaxPlus> {};
+
+    // Boolean rows: skip the whole B row when a is false, otherwise OR in B != 0
+    template <>
+    struct TileKernel<Semiring::OrAnd> {
+        static void run(MatView mat1, MatView mat2, Mat& result, int i0, int i1, int j0, int j1, int k0, int k1) {
+            for (int ii = i0; ii < i1; ii++) {
+                int* c_row = result.matrix.data() + ii * result.cols;
+                for (int kk = k0; kk < k1; kk++) {
+                    if (mat1.matrix[ii * mat1.cols + kk] == 0) continue;
+                    const int* b_row = mat2.matrix + kk * mat2.cols;
+                    for (int jj = j0; jj < j1; jj++) {
+                        c_row[jj] |= (b_row[jj] != 0);
+                    }
+                }
+            }
+        }
+    };
+
+    // Modular rows: i-k-j with one 64-bit lazy accumulator per output column, reduced once per tile
+    template <uint32_t P>
+    struct TileKernel<Semiring::ModP<P>> {
+        static void run(MatView mat1, MatView mat2, Mat& result, int i0, int i1, int j0, int j1, int k0, int k1) {
+            using S = Semiring::ModP<P>;
+            std::vector<uint64_t> acc(j1 - j0);
+            for (int ii = i0; ii < i1; ii++) {
+                std::fill(acc.begin(), acc.end(), S::acc_zero());
+                for (int kk = k0; kk < k1; kk++) {
+                    const int a = mat1.matrix[ii * mat1.cols + kk];
+                    const int* b_row = mat2.matrix + kk * mat2.cols + j0;
+                    for (int jj = 0; jj < j1 - j0; jj++) acc[jj] = S::accumulate(acc[jj], a, b_row[jj]);
+                }
+                int* c_row = result.matrix.data() + ii * result.cols + j0;
+                for (int jj = 0; jj < j1 - j0; jj++) c_row[jj] = S::add(c_row[jj], S::reduce(acc[jj]));
+            }
+        }
+    };
+
+    // Bring arbitrary ints into [0, P) before a modular multiply
+    template <uint32_t P>
+    void reduceMod(Mat& mat) {
+        for (int& x : mat.matrix) {
+            long long r = x % static_cast<long long>(P);
+            x = static_cast<int>(r < 0 ? r + P : r);
+        }
+    }
+
+    template <class S = PlusTimes>
+    void BlockedMul(MatView mat1, MatView mat2, Mat& result, Update update = Update::Overwrite) {
+        checkResult(mat1, mat2, result);
+        if (update == Update::Overwrite) std::fill(result.matrix.begin(), result.matrix.end(), S::zero());
+
         for (int i = 0; i < mat1.rows; i += BLOCK_SIZE) {
             for (int j = 0; j < mat2.cols; j += BLOCK_SIZE) {
                 for (int k = 0; k < mat1.cols; k += BLOCK_SIZE) {
-                    for (int ii = i; ii < (std::min)(i + BLOCK_SIZE, mat1.rows); ii++) {
-                        for (int jj = j; jj < (std::min)(j + BLOCK_SIZE, mat2.cols); jj++) {
-                            int sum = 0;
-                            for (int kk = k; kk < (std::min)(k + BLOCK_SIZE, mat1.cols); kk++) {
-                                sum += mat1.matrix[ii * mat1.cols + kk] * mat2.matrix[kk * mat2.cols + jj];
-                            }
-                            result.matrix[ii * result.cols + jj] += sum;
-                        }
-                    }
+                    TileKernel<S>::run(mat1, mat2, result,
+                                       i, (std::min)(i + BLOCK_SIZE, mat1.rows),
+                                       j, (std::min)(j + BLOCK_SIZE, mat2.cols),
+                                       k, (std::min)(k + BLOCK_SIZE, mat1.cols));
                 }
             }
         }
+    }
+
+    template <class S = PlusTimes>
+    Mat BlockedMul(MatView mat1, MatView mat2){
+        Mat result = semiringZeros<S>(mat1.rows, mat2.cols);
+        BlockedMul<S>(mat1, mat2, result, Update::Accumulate);
+        return result;
+    }
+
+    template <class S = PlusTimes>
+    Mat BlockedMul(MatView mat1, MatView mat2, Mat&& storage) {
+        Mat result = reshapeMat(std::move(storage), mat1.rows, mat2.cols);
+        BlockedMul<S>(mat1, mat2, result);
         return result;
     }
  
-    void BlockedMul_threading_helper(const Mat& mat1, const Mat& mat2, Mat& result, int BLOCK_SIZE, int i, int j) {
-        for (int k = 0; k < mat1.cols; k += BLOCK_SIZE) {
-            for (int ii = i; ii < (std::min)(i + BLOCK_SIZE, mat1.rows); ii++) {
-                for (int jj = j; jj < (std::min)(j + BLOCK_SIZE, mat2.cols); jj++) {
-                    int sum = 0;
-                    for (int kk = k; kk < (std::min)(k + BLOCK_SIZE, mat1.cols); kk++) {
-                        sum += mat1.matrix[ii * mat1.cols + kk] * mat2.matrix[kk * mat2.cols + jj];
-                    }
-                    result.matrix[ii * result.cols + jj] += sum;
-                }
-            }
+    // Accumulate the (i, j) output tile over the shared dimension range [k_start, k_end)
+    template <class S = PlusTimes>
+    void BlockedMul_tile(MatView mat1, MatView mat2, Mat& result, int BLOCK_SIZE,
+                         int i, int j, int k_start, int k_end) {
+        for (int k = k_start; k < k_end; k += BLOCK_SIZE) {
+            TileKernel<S>::run(mat1, mat2, result,
+                               i, (std::min)(i + BLOCK_SIZE, mat1.rows),
+                               j, (std::min)(j + BLOCK_SIZE, mat2.cols),
+                               k, (std::min)(k + BLOCK_SIZE, k_end));
         }
     }
+
+    void BlockedMul_threading_helper(MatView mat1, MatView mat2, Mat& result, int BLOCK_SIZE, int i, int j) {
+        BlockedMul_tile(mat1, mat2, result, BLOCK_SIZE, i, j, 0, mat1.cols);
+    }
     
-    Mat BlockedMul_threading(const Mat& mat1, const Mat& mat2, int BLOCK_SIZE) {
-        Mat result(mat1.rows, mat2.cols);
-        std::vector<std::thread> threads;
-        for (int i = 0; i < mat1.rows; i += BLOCK_SIZE) {
-            for (int j = 0; j < mat2.cols; j += BLOCK_SIZE) {
-                threads.emplace_back(BlockedMul_threading_helper, 
-                                     std::ref(mat1), std::ref(mat2), std::ref(result), 
-                                     BLOCK_SIZE, i, j);
+    // Runs worker(t) on config.thread_count threads, pinned according to config.policy and
+    // confined to config.cpu_list. A single unplaced worker runs on the calling thread; otherwise
+    // the placement's shared WorkerPool runs them, or, while that pool is serving another call,
+    // threads started and joined for this one.
+    template <typename Worker>
+    void runWorkers(const ThreadConfig& config, Worker worker) {
+        int thread_count = resolveThreadCount(config);
+        if (thread_count == 1 && config.policy == AffinityPolicy::None && config.cpu_list.empty()) {
+            worker(0);
+            return;
+        }
+        if (sharedWorkerPool(config, thread_count).run(worker)) return;
+        auto threads = startPlacedThreads(config, thread_count, [&worker](int t) { worker(t); });
+        for (auto& th : threads) th.join();
+    }
+
+    // Number of slices to split the shared (K) dimension into.
+    // Output tiles alone are used while there are enough of them to keep every thread busy;
+    // otherwise K is split so tiles * slices covers the threads, keeping at least
+    // 4 blocks per slice and the private partial buffers under 256 MB.
+    int chooseKSplits(MatView mat1, MatView mat2, int BLOCK_SIZE, int thread_count) {
+        long long row_tiles = (mat1.rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        long long col_tiles = (mat2.cols + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        long long tiles = row_tiles * col_tiles;
+        if (tiles == 0 || tiles >= thread_count) return 1;
+
+        long long k_blocks = (mat1.cols + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        long long splits = (thread_count + tiles - 1) / tiles;
+        splits = (std::min)(splits, k_blocks / 4);
+
+        long long result_bytes = static_cast<long long>(mat1.rows) * mat2.cols * sizeof(int);
+        long long max_buffers = (256LL << 20) / (std::max)(result_bytes, 1LL);
+        splits = (std::min)(splits, max_buffers + 1);
+        return static_cast<int>((std::max)(splits, 1LL));
+    }
+
+    // 3D decomposition: (i, j) output tiles x k_splits slices of the shared dimension.
+    // Slice 0 accumulates into the result, the others into private partial buffers
+    // that are then summed by a parallel pairwise tree reduction. The partials come from
+    // the workspace when one is given, so repeated calls reuse them.
+    template <class S = PlusTimes>
+    void BlockedMul_threading_ksplit(MatView mat1, MatView mat2, Mat& result, int BLOCK_SIZE, int k_splits,
+                                     const ThreadConfig& config = {}, Update update = Update::Overwrite,
+                                     MulWorkspace* workspace = nullptr) {
+        checkResult(mat1, mat2, result);
+        if (update == Update::Overwrite) std::fill(result.matrix.begin(), result.matrix.end(), S::zero());
+        int row_tiles = (mat1.rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        int col_tiles = (mat2.cols + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        int k_blocks = (mat1.cols + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        k_splits = (std::max)(1, (std::min)(k_splits, k_blocks));
+
+        std::vector<Mat> local;
+        std::vector<Mat>& partials = workspace ? workspace->partials : local;
+        if (partials.size() < size_t(k_splits - 1)) partials.resize(k_splits - 1, Mat(0, 0));
+        for (int s = 1; s < k_splits; s++) {
+            partials[s - 1] = reshapeMat(std::move(partials[s - 1]), mat1.rows, mat2.cols);
+            std::fill(partials[s - 1].matrix.begin(), partials[s - 1].matrix.end(), S::zero());
+        }
+        auto buffer = [&](int s) -> Mat& { return s == 0 ? result : partials[s - 1]; };
+
+        // Tiles are handed out column-major (j outer), so workers running at the same time
+        // read the same B panel; with compact placement they also share an L2/L3.
+        int task_count = row_tiles * col_tiles * k_splits;
+        std::atomic<int> next_task{0};
+        runWorkers(config, [&](int) {
+            for (int task = next_task++; task < task_count; task = next_task++) {
+                int slice = task % k_splits;
+                int tile = task / k_splits;
+                int i = (tile % row_tiles) * BLOCK_SIZE;
+                int j = (tile / row_tiles) * BLOCK_SIZE;
+                int k_start = static_cast<int>(static_cast<long long>(slice) * k_blocks / k_splits) * BLOCK_SIZE;
+                int k_end = (std::min)(static_cast<int>(static_cast<long long>(slice + 1) * k_blocks / k_splits) * BLOCK_SIZE,
+                                       mat1.cols);
+                BlockedMul_tile<S>(mat1, mat2, buffer(slice), BLOCK_SIZE, i, j, k_start, k_end);
             }
+        });
+
+        // Each round adds buffer[s + stride] into buffer[s], split into row chunks across the workers
+        const int chunk_rows = (std::max)(1, 16384 / (std::max)(1, result.cols));
+        int chunks = (result.rows + chunk_rows - 1) / chunk_rows;
+        for (int stride = 1; stride < k_splits; stride *= 2) {
+            int pairs = 0;
+            for (int s = 0; s + stride < k_splits; s += 2 * stride) pairs++;
+            int round_tasks = pairs * chunks;
+            std::atomic<int> next{0};
+            runWorkers(config, [&](int) {
+                for (int task = next++; task < round_tasks; task = next++) {
+                    int s = (task / chunks) * 2 * stride;
+                    int row_start = (task % chunks) * chunk_rows;
+                    int row_end = (std::min)(row_start + chunk_rows, result.rows);
+                    Mat& dst = buffer(s);
+                    const Mat& src = buffer(s + stride);
+                    for (int idx = row_start * result.cols; idx < row_end * result.cols; idx++) {
+                        dst.matrix[idx] = S::add(dst.matrix[idx], src.matrix[idx]);
+                    }
+                }
+            });
         }
-        for (auto& t : threads) t.join();
+    }
+
+    template <class S = PlusTimes>
+    Mat BlockedMul_threading_ksplit(MatView mat1, MatView mat2, int BLOCK_SIZE, int k_splits,
+                                    const ThreadConfig& config = {}) {
+        Mat result = semiringZeros<S>(mat1.rows, mat2.cols);
+        BlockedMul_threading_ksplit<S>(mat1, mat2, result, BLOCK_SIZE, k_splits, config, Update::Accumulate);
+        return result;
+    }
+
+    // Picks a 2D (output tiles only) or 3D (tiles x K slices) decomposition by shape.
+    // The result and, with a workspace, the K-split partials are reused across calls, and the
+    // workers come from the placement's persistent pool (see runWorkers).
+    template <class S = PlusTimes>
+    void BlockedMul_threading(MatView mat1, MatView mat2, Mat& result, int BLOCK_SIZE, const ThreadConfig& config = {},
+                              Update update = Update::Overwrite, MulWorkspace* workspace = nullptr) {
+        int k_splits = chooseKSplits(mat1, mat2, BLOCK_SIZE, resolveThreadCount(config));
+        BlockedMul_threading_ksplit<S>(mat1, mat2, result, BLOCK_SIZE, k_splits, config, update, workspace);
+    }
+
+    template <class S = PlusTimes>
+    Mat BlockedMul_threading(MatView mat1, MatView mat2, int BLOCK_SIZE, const ThreadConfig& config = {}) {
+        int k_splits = chooseKSplits(mat1, mat2, BLOCK_SIZE, resolveThreadCount(config));
+        return BlockedMul_threading_ksplit<S>(mat1, mat2, BLOCK_SIZE, k_splits, config);
+    }
+
+    template <class S = PlusTimes>
+    Mat BlockedMul_threading(MatView mat1, MatView mat2, Mat&& storage, int BLOCK_SIZE, const ThreadConfig& config = {},
+                             MulWorkspace* workspace = nullptr) {
+        Mat result = reshapeMat(std::move(storage), mat1.rows, mat2.cols);
+        BlockedMul_threading<S>(mat1, mat2, result, BLOCK_SIZE, config, Update::Overwrite, workspace);
         return result;
     }
 
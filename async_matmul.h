@@ -0,0 +1,269 @@
+#pragma once
+
+// Asynchronous multiplies on a shared worker pool.
+// multiply_async(A, B) returns at once with a MulFuture; the pool's workers compute the product
+// one output tile at a time, so independent jobs share the workers and the caller keeps issuing
+// work (or doing its own I/O) while earlier products run. A MulFuture can be waited on (get),
+// given continuations (then) or awaited from a C++20 coroutine (co_await).
+// Jobs are cut into tiles, so the pool picks which job's tile runs next according to Fairness:
+//   Fifo       - jobs in arrival order: the oldest job finishes first, later ones queue behind it;
+//   RoundRobin - one tile from each active job in turn, so every job progresses at the same rate;
+//   SmallFirst - the job with the least remaining work first: the lowest latency for small jobs,
+//                while a large job only runs when nothing smaller is waiting.
+// Tiles are only the unit of scheduling: each one is computed in the same block x block x block
+// kernel calls as BlockedMul_threading, block being BLOCK_SIZE clipped to the tile.
+// Operands are views and must stay alive until the future is ready.
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "Rec_MatMul.h"
+
+enum class Fairness { Fifo, RoundRobin, SmallFirst };
+
+const char* fairnessName(Fairness fairness) {
+    switch (fairness) {
+        case Fairness::Fifo: return "fifo";
+        case Fairness::RoundRobin: return "round-robin";
+        default: return "small-first";
+    }
+}
+
+namespace MatMath {
+
+    // Shared state of one submitted multiply
+    struct MulJob {
+        Mat result;
+        int tiles = 0;
+        int next_tile = 0;                      // first tile not yet handed out (guarded by the pool)
+        long long tile_macs = 0;                // work of one tile, for SmallFirst
+        std::atomic<int> done_tiles{0};
+        std::function<void(MulJob&, int)> run_tile;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool ready = false;
+        std::vector<std::function<void(const Mat&)>> continuations;
+        std::vector<std::coroutine_handle<>> awaiters;
+
+        MulJob(int rows, int cols) : result(rows, cols) {}
+
+        // Run by the worker that finished the last tile. Continuations all run before the job is
+        // marked ready (one added meanwhile is picked up by the next round), then waiters wake
+        // and suspended coroutines resume on this thread.
+        void complete() {
+            std::vector<std::coroutine_handle<>> resume;
+            for (;;) {
+                std::vector<std::function<void(const Mat&)>> pending;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (continuations.empty()) {
+                        ready = true;
+                        resume.swap(awaiters);
+                        break;
+                    }
+                    pending.swap(continuations);
+                }
+                for (auto& continuation : pending) continuation(result);
+            }
+            cv.notify_all();
+            for (auto handle : resume) handle.resume();
+        }
+    };
+
+    class MulFuture {
+    public:
+        explicit MulFuture(std::shared_ptr<MulJob> job) : job_(std::move(job)) {}
+
+        bool ready() const {
+            std::lock_guard<std::mutex> lock(job_->mutex);
+            return job_->ready;
+        }
+
+        void wait() const {
+            std::unique_lock<std::mutex> lock(job_->mutex);
+            job_->cv.wait(lock, [&] { return job_->ready; });
+        }
+
+        const Mat& get() const {
+            wait();
+            return job_->result;
+        }
+
+        // Waits and moves the product out; only for a future that is the product's sole consumer
+        Mat take() {
+            wait();
+            return std::move(job_->result);
+        }
+
+        // f(result) runs on the worker that finishes the job, or right here if it already has
+        template <class F>
+        void then(F f) {
+            {
+                std::lock_guard<std::mutex> lock(job_->mutex);
+                if (!job_->ready) {
+                    job_->continuations.emplace_back(std::move(f));
+                    return;
+                }
+            }
+            f(job_->result);
+        }
+
+        // co_await future: suspends until the product is ready and resumes on the finishing worker
+        bool await_ready() const { return ready(); }
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::lock_guard<std::mutex> lock(job_->mutex);
+            if (job_->ready) return false;
+            job_->awaiters.push_back(handle);
+            return true;
+        }
+        const Mat& await_resume() const { return job_->result; }
+
+    private:
+        std::shared_ptr<MulJob> job_;
+    };
+
+    // Minimal eager, fire-and-forget coroutine type for code that co_awaits MulFutures
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    // Worker threads taking tiles from every active job. Destruction finishes the queued work.
+    class MulPool {
+    public:
+        static constexpr int DEFAULT_TILE = 256;
+
+        explicit MulPool(const ThreadConfig& config = {}, Fairness fairness = Fairness::RoundRobin, int tile = DEFAULT_TILE)
+            : fairness_(fairness), tile_(tile) {
+            workers_ = startPlacedThreads(config, resolveThreadCount(config), [this](int) { workerLoop(); });
+        }
+
+        ~MulPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            cv_.notify_all();
+            for (auto& worker : workers_) worker.join();
+        }
+
+        MulPool(const MulPool&) = delete;
+        MulPool& operator=(const MulPool&) = delete;
+
+        void setFairness(Fairness fairness) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fairness_ = fairness;
+        }
+
+        int tile() const { return tile_; }
+        // Kernel block within a tile
+        int block() const { return (std::min)(BLOCK_SIZE, tile_); }
+        int threads() const { return static_cast<int>(workers_.size()); }
+
+        void submit(std::shared_ptr<MulJob> job) {
+            if (job->tiles == 0) {
+                job->complete();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                active_.push_back(std::move(job));
+            }
+            cv_.notify_all();
+        }
+
+    private:
+        // Index in active_ of the job whose tile runs next (called with the lock held)
+        size_t choose() const {
+            if (fairness_ != Fairness::SmallFirst) return 0;
+            size_t best = 0;
+            for (size_t n = 1; n < active_.size(); n++) {
+                auto remaining = [&](size_t idx) { return (active_[idx]->tiles - active_[idx]->next_tile) * active_[idx]->tile_macs; };
+                if (remaining(n) < remaining(best)) best = n;
+            }
+            return best;
+        }
+
+        void workerLoop() {
+            for (;;) {
+                std::shared_ptr<MulJob> job;
+                int tile;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait(lock, [&] { return stopping_ || !active_.empty(); });
+                    if (active_.empty()) return;
+                    size_t pick = choose();
+                    job = active_[pick];
+                    tile = job->next_tile++;
+                    if (job->next_tile == job->tiles) {
+                        active_.erase(active_.begin() + pick);
+                    } else if (fairness_ == Fairness::RoundRobin) {
+                        active_.pop_front();
+                        active_.push_back(job);
+                    }
+                }
+                job->run_tile(*job, tile);
+                if (++job->done_tiles == job->tiles) job->complete();
+            }
+        }
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<std::shared_ptr<MulJob>> active_;   // jobs with tiles not yet handed out
+        bool stopping_ = false;
+        Fairness fairness_;
+        int tile_;
+        std::vector<std::thread> workers_;
+    };
+
+    // Process-wide pool on every hardware thread, started on first use
+    MulPool& sharedPool() {
+        static MulPool pool;
+        return pool;
+    }
+
+    // Output rows [i0, i1) x columns [j0, j1) in block-sized kernel calls, k innermost as in BlockedMul_tile
+    template <class S = PlusTimes>
+    void multiplyRegion(MatView mat1, MatView mat2, Mat& result, int block, int i0, int i1, int j0, int j1) {
+        for (int i = i0; i < i1; i += block) {
+            for (int j = j0; j < j1; j += block) {
+                for (int k = 0; k < mat1.cols; k += block) {
+                    TileKernel<S>::run(mat1, mat2, result, i, (std::min)(i + block, i1), j, (std::min)(j + block, j1),
+                                       k, (std::min)(k + block, mat1.cols));
+                }
+            }
+        }
+    }
+
+    template <class S = PlusTimes>
+    MulFuture multiply_async(MatView mat1, MatView mat2, MulPool& pool = sharedPool()) {
+        if (mat1.cols != mat2.rows) throw std::invalid_argument("operand shapes do not match");
+        auto job = std::make_shared<MulJob>(mat1.rows, mat2.cols);
+        if (S::zero() != 0) std::fill(job->result.matrix.begin(), job->result.matrix.end(), S::zero());
+        const int tile = pool.tile(), block = pool.block();
+        const int row_tiles = (mat1.rows + tile - 1) / tile;
+        const int col_tiles = (mat2.cols + tile - 1) / tile;
+        job->tiles = row_tiles * col_tiles;
+        job->tile_macs = static_cast<long long>(tile) * tile * (std::max)(mat1.cols, 1);
+        job->run_tile = [mat1, mat2, tile, block, row_tiles](MulJob& job, int t) {
+            const int i = (t % row_tiles) * tile, j = (t / row_tiles) * tile;
+            multiplyRegion<S>(mat1, mat2, job.result, block, i, (std::min)(i + tile, mat1.rows), j, (std::min)(j + tile, mat2.cols));
+        };
+        pool.submit(job);
+        return MulFuture(job);
+    }
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+// Bit-packed boolean matrices (64 entries per word) and the (or, and) product using the
+// Method of Four Russians: rows of B are taken 8 at a time, all 256 OR-combinations of those
+// rows are tabulated, and every row of C ORs in the one entry selected by the matching byte of A.
+// Tables cover a block of columns sized to half of L1, the bit-level counterpart of BLOCK_SIZE,
+// and each table row is combined with word-wide AND/OR that the compiler vectorizes.
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+#include "Rec_MatMul.h"
+
+struct BitMat {
+    int rows, cols;
+    int words;                  // 64-bit words per row
+    std::vector<uint64_t> bits; // row-major, bits past `cols` in the last word are always 0
+
+    BitMat(int r, int c) : rows(r), cols(c), words((c + 63) / 64), bits(size_t(r) * ((c + 63) / 64), 0) {}
+
+    uint64_t* row(int i) { return bits.data() + size_t(i) * words; }
+    const uint64_t* row(int i) const { return bits.data() + size_t(i) * words; }
+
+    bool get(int i, int j) const { return (row(i)[j / 64] >> (j % 64)) & 1; }
+    void set(int i, int j, bool value) {
+        uint64_t mask = uint64_t(1) << (j % 64);
+        if (value) row(i)[j / 64] |= mask;
+        else row(i)[j / 64] &= ~mask;
+    }
+
+    // Number of true entries
+    long long count() const {
+        long long total = 0;
+        for (uint64_t word : bits) total += std::popcount(word);
+        return total;
+    }
+
+    // Nonzero entries become true
+    static BitMat fromMat(MatView mat) {
+        BitMat out(mat.rows, mat.cols);
+        for (int i = 0; i < mat.rows; i++) {
+            uint64_t* dst = out.row(i);
+            const int* src = mat.matrix + size_t(i) * mat.cols;
+            for (int j = 0; j < mat.cols; j++) {
+                dst[j / 64] |= uint64_t(src[j] != 0) << (j % 64);
+            }
+        }
+        return out;
+    }
+
+    Mat toMat() const {
+        Mat out(rows, cols);
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) out.matrix[size_t(i) * cols + j] = get(i, j);
+        }
+        return out;
+    }
+};
+
+namespace MatMath {
+
+    // Words of C per Four Russians table row: 256 table rows of this width fill half of L1
+    int bitTableWords() {
+        size_t l1 = getL1CacheSize();
+        if (l1 == 0) l1 = 32 * 1024;
+        int words = static_cast<int>(l1 / 2 / (256 * sizeof(uint64_t)));
+        return (std::max)(1, words);
+    }
+
+    // C = A (or, and) B. Column blocks of C are independent and shared out across the workers.
+    BitMat BitMul(const BitMat& mat1, const BitMat& mat2, const ThreadConfig& config = {}) {
+        if (mat1.cols != mat2.rows) throw std::invalid_argument("operand shapes do not match");
+        BitMat result(mat1.rows, mat2.cols);
+        const int W = (std::min)(bitTableWords(), (std::max)(1, mat2.words));
+        const int column_blocks = (mat2.words + W - 1) / W;
+        std::atomic<int> next_block{0};
+
+        runWorkers(config, [&](int) {
+            std::vector<uint64_t> table(size_t(256) * W);
+            for (int block = next_block++; block < column_blocks; block = next_block++) {
+                const int w0 = block * W;
+                const int width = (std::min)(W, mat2.words - w0);
+
+                for (int k = 0; k < mat1.cols; k += 8) {
+                    const int group = (std::min)(8, mat1.cols - k);
+
+                    // table[x] = OR of B rows k + b for every bit b set in x, built from smaller entries
+                    std::fill(table.begin(), table.begin() + width, 0);
+                    for (int x = 1; x < (1 << group); x++) {
+                        const uint64_t* low = table.data() + size_t(x & (x - 1)) * W;
+                        const uint64_t* b_row = mat2.row(k + std::countr_zero(static_cast<unsigned>(x))) + w0;
+                        uint64_t* entry = table.data() + size_t(x) * W;
+                        for (int w = 0; w < width; w++) entry[w] = low[w] | b_row[w];
+                    }
+
+                    // Byte of A covering columns k .. k + 7, never straddling a word since k % 8 == 0
+                    const int a_word = k / 64, a_shift = k % 64;
+                    const uint64_t a_mask = (uint64_t(1) << group) - 1;
+                    for (int i = 0; i < mat1.rows; i++) {
+                        const unsigned index = static_cast<unsigned>((mat1.row(i)[a_word] >> a_shift) & a_mask);
+                        if (index == 0) continue;
+                        const uint64_t* entry = table.data() + size_t(index) * W;
+                        uint64_t* c_row = result.row(i) + w0;
+                        for (int w = 0; w < width; w++) c_row[w] |= entry[w];
+                    }
+                }
+            }
+        });
+        return result;
+    }
+
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+// Block-sparse variants of the blocked multiply for inputs where whole tiles are empty.
+// A TileOccupancy bitmap records which block x block tiles hold anything other than the
+// semiring zero; it is computed once per matrix and reused across products. The multiplies
+// skip every (i, k) x (k, j) tile pair where either side is empty, which relies on zero()
+// annihilating under mul() (exactly so for (+, *), (or, and) and ModP).
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "Rec_MatMul.h"
+
+struct TileOccupancy {
+    int tile_rows, tile_cols;
+    int block;
+    int words;                  // 64-bit words per tile row
+    std::vector<uint64_t> bits; // bit (ti, tj) set when the tile holds a nonzero
+
+    TileOccupancy(int r, int c, int b)
+        : tile_rows(r), tile_cols(c), block(b), words((c + 63) / 64), bits(size_t(r) * ((c + 63) / 64), 0) {}
+
+    bool occupied(int ti, int tj) const { return (bits[size_t(ti) * words + tj / 64] >> (tj % 64)) & 1; }
+
+    long long count() const {
+        long long total = 0;
+        for (uint64_t word : bits) total += std::popcount(word);
+        return total;
+    }
+
+    // Tile rows are scanned in parallel; within a row band a tile stops being scanned once it is occupied
+    template <class S = MatMath::PlusTimes>
+    static TileOccupancy compute(MatView mat, int block = BLOCK_SIZE, const ThreadConfig& config = {}) {
+        TileOccupancy occ((mat.rows + block - 1) / block, (mat.cols + block - 1) / block, block);
+        const int zero = S::zero();
+        int thread_count = resolveThreadCount(config);
+        MatMath::runWorkers(config, [&](int t) {
+            for (int ti = t; ti < occ.tile_rows; ti += thread_count) {
+                uint64_t* word = occ.bits.data() + size_t(ti) * occ.words;
+                int r1 = (std::min)((ti + 1) * block, mat.rows);
+                for (int tj = 0; tj < occ.tile_cols; tj++) {
+                    int c0 = tj * block, c1 = (std::min)(c0 + block, mat.cols);
+                    for (int r = ti * block; r < r1; r++) {
+                        const int* row = mat.matrix + size_t(r) * mat.cols;
+                        if (std::any_of(row + c0, row + c1, [zero](int x) { return x != zero; })) {
+                            word[tj / 64] |= uint64_t(1) << (tj % 64);
+                            break;
+                        }
+                    }
+                }
+            }
+        });
+        return occ;
+    }
+};
+
+namespace MatMath {
+
+    void checkOccupancy(MatView mat1, MatView mat2, const TileOccupancy& occ1, const TileOccupancy& occ2) {
+        if (mat1.cols != mat2.rows) throw std::invalid_argument("operand shapes do not match");
+        if (occ1.block != occ2.block || occ1.tile_rows != (mat1.rows + occ1.block - 1) / occ1.block ||
+            occ1.tile_cols != (mat1.cols + occ1.block - 1) / occ1.block ||
+            occ2.tile_rows != (mat2.rows + occ2.block - 1) / occ2.block ||
+            occ2.tile_cols != (mat2.cols + occ2.block - 1) / occ2.block) {
+            throw std::invalid_argument("tile occupancy does not match the operands");
+        }
+    }
+
+    // Shared-dimension ranges [k_start, k_end) of the nonempty k tiles shared by A tile row ti and
+    // B tile column tj, with consecutive tiles merged into one range
+    std::vector<std::pair<int, int>> tilePairs(const TileOccupancy& occ1, const TileOccupancy& occ2, int ti, int tj,
+                                               int k_limit) {
+        std::vector<std::pair<int, int>> ranges;
+        for (int tk = 0; tk < occ1.tile_cols; tk++) {
+            if (!occ1.occupied(ti, tk) || !occ2.occupied(tk, tj)) continue;
+            int k_start = tk * occ1.block, k_end = (std::min)(k_start + occ1.block, k_limit);
+            if (!ranges.empty() && ranges.back().second == k_start) ranges.back().second = k_end;
+            else ranges.push_back({k_start, k_end});
+        }
+        return ranges;
+    }
+
+    // Number of tile pairs covered by the ranges
+    long long pairCount(const std::vector<std::pair<int, int>>& ranges, int block) {
+        long long count = 0;
+        for (auto [k_start, k_end] : ranges) count += (k_end - k_start + block - 1) / block;
+        return count;
+    }
+
+    template <class S = PlusTimes>
+    Mat BlockedMul_blocksparse(MatView mat1, MatView mat2, const TileOccupancy& occ1, const TileOccupancy& occ2) {
+        checkOccupancy(mat1, mat2, occ1, occ2);
+        Mat result = semiringZeros<S>(mat1.rows, mat2.cols);
+        for (int ti = 0; ti < occ1.tile_rows; ti++) {
+            for (int tj = 0; tj < occ2.tile_cols; tj++) {
+                for (auto [k_start, k_end] : tilePairs(occ1, occ2, ti, tj, mat1.cols)) {
+                    BlockedMul_tile<S>(mat1, mat2, result, occ1.block, ti * occ1.block, tj * occ1.block, k_start, k_end);
+                }
+            }
+        }
+        return result;
+    }
+
+    // Output tiles weighted by their nonempty tile pairs: tiles with no work are dropped, the rest
+    // are handed out heaviest first so the last tiles to finish are the cheap ones
+    template <class S = PlusTimes>
+    Mat BlockedMul_threading_blocksparse(MatView mat1, MatView mat2, const TileOccupancy& occ1,
+                                         const TileOccupancy& occ2, const ThreadConfig& config = {}) {
+        checkOccupancy(mat1, mat2, occ1, occ2);
+        Mat result = semiringZeros<S>(mat1.rows, mat2.cols);
+
+        struct SparseTile {
+            int ti, tj;
+            long long pairs;
+            std::vector<std::pair<int, int>> ranges;
+        };
+        std::vector<SparseTile> tiles;
+        for (int tj = 0; tj < occ2.tile_cols; tj++) {
+            for (int ti = 0; ti < occ1.tile_rows; ti++) {
+                auto ranges = tilePairs(occ1, occ2, ti, tj, mat1.cols);
+                if (!ranges.empty()) tiles.push_back({ti, tj, pairCount(ranges, occ1.block), std::move(ranges)});
+            }
+        }
+        std::stable_sort(tiles.begin(), tiles.end(),
+                         [](const SparseTile& a, const SparseTile& b) { return a.pairs > b.pairs; });
+
+        std::atomic<size_t> next_tile{0};
+        runWorkers(config, [&](int) {
+            for (size_t n = next_tile++; n < tiles.size(); n = next_tile++) {
+                const SparseTile& tile = tiles[n];
+                for (auto [k_start, k_end] : tile.ranges) {
+                    BlockedMul_tile<S>(mat1, mat2, result, occ1.block, tile.ti * occ1.block, tile.tj * occ1.block,
+                                       k_start, k_end);
+                }
+            }
+        });
+        return result;
+    }
+
+}
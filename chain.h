@@ -0,0 +1,211 @@
+#pragma once
+
+// Matrix-chain products A1 * A2 * ... * An.
+// planChain runs the classic O(n^3) dynamic program over split points, but prices each step
+// with measured kernel speed instead of raw m * k * n: every dimension is bucketed into a size
+// class, and the first time a (class, class, class) shape is priced, both candidate kernels
+// (recursive matMul and the threaded blocked multiply) are timed on a probe of that class.
+// Each step of the plan records the faster kernel. multiplyChain then executes the plan with
+// intermediates drawn from a small buffer pool: a step's operands go back to the pool as soon
+// as it finishes, so later steps reuse their storage instead of allocating.
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "Rec_MatMul.h"
+
+enum class ChainKernel { Recursive, Blocked };
+
+const char* chainKernelName(ChainKernel kernel) { return kernel == ChainKernel::Recursive ? "recursive" : "blocked"; }
+
+namespace MatMath {
+
+    // out = A * B with the chosen kernel, written into an existing buffer of the right shape
+    void chainStep(ChainKernel kernel, MatView mat1, MatView mat2, Mat& out, const ThreadConfig& config) {
+        if (kernel == ChainKernel::Recursive) {
+            matMul(out, mat1, mat2, 0, mat1.rows, 0, mat1.cols, 0, mat2.rows, 0, mat2.cols, 0, 0);
+        } else {
+            BlockedMul_threading(mat1, mat2, out, BLOCK_SIZE, config);
+        }
+    }
+
+    // Seconds per multiply-accumulate for each kernel, measured lazily per shape class
+    class ChainCostModel {
+    public:
+        explicit ChainCostModel(const ThreadConfig& config = {}) : config_(config) {}
+
+        // Dimension buckets and the probe size that stands for each
+        static int shapeClass(int dim) { return dim <= 64 ? 0 : (dim <= 512 ? 1 : 2); }
+        static int probeSize(int shape_class) { return shape_class == 0 ? 32 : (shape_class == 1 ? 128 : 384); }
+
+        double secondsPerMac(int m, int k, int n, ChainKernel kernel) {
+            std::array<int, 3> key{shapeClass(m), shapeClass(k), shapeClass(n)};
+            auto found = measured_.find(key);
+            if (found == measured_.end()) found = measured_.emplace(key, measure(key)).first;
+            return found->second[kernel == ChainKernel::Recursive ? 0 : 1];
+        }
+
+        // Cheaper kernel for the step and its predicted time in seconds
+        std::pair<ChainKernel, double> price(int m, int k, int n) {
+            double macs = double(m) * k * n;
+            double recursive = macs * secondsPerMac(m, k, n, ChainKernel::Recursive);
+            double blocked = macs * secondsPerMac(m, k, n, ChainKernel::Blocked);
+            return recursive < blocked ? std::pair{ChainKernel::Recursive, recursive} : std::pair{ChainKernel::Blocked, blocked};
+        }
+
+        int probes() const { return static_cast<int>(measured_.size()); }
+
+    private:
+        std::array<double, 2> measure(const std::array<int, 3>& key) {
+            int m = probeSize(key[0]), k = probeSize(key[1]), n = probeSize(key[2]);
+            Mat a(m, k), b(k, n), out(m, n);
+            for (size_t idx = 0; idx < a.matrix.size(); idx++) a.matrix[idx] = int(idx % 7);
+            for (size_t idx = 0; idx < b.matrix.size(); idx++) b.matrix[idx] = int(idx % 5);
+            std::array<double, 2> result{};
+            for (ChainKernel kernel : {ChainKernel::Recursive, ChainKernel::Blocked}) {
+                double best = 0;
+                for (int rep = 0; rep < 2; rep++) {
+                    auto start = std::chrono::steady_clock::now();
+                    chainStep(kernel, a, b, out, config_);
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    if (rep == 0 || seconds < best) best = seconds;
+                }
+                result[kernel == ChainKernel::Recursive ? 0 : 1] = best / (double(m) * k * n);
+            }
+            return result;
+        }
+
+        ThreadConfig config_;
+        std::map<std::array<int, 3>, std::array<double, 2>> measured_;
+    };
+
+    struct ChainPlan {
+        int count = 0;                          // matrices in the chain
+        std::vector<int> split;                 // split[i * count + j]: last matrix of the left half of (i..j)
+        std::vector<ChainKernel> kernel;        // kernel[i * count + j]: kernel for the final product of (i..j)
+        double predicted_seconds = 0;
+
+        int splitOf(int i, int j) const { return split[size_t(i) * count + j]; }
+        ChainKernel kernelOf(int i, int j) const { return kernel[size_t(i) * count + j]; }
+
+        // Parenthesization, e.g. "((A1 A2) A3)"
+        std::string describe(int i, int j) const {
+            if (i == j) return "A" + std::to_string(i + 1);
+            return "(" + describe(i, splitOf(i, j)) + " " + describe(splitOf(i, j) + 1, j) + ")";
+        }
+        std::string describe() const { return count ? describe(0, count - 1) : ""; }
+    };
+
+    ChainPlan planChain(const std::vector<MatView>& chain, ChainCostModel& model) {
+        const int n = static_cast<int>(chain.size());
+        for (int i = 0; i + 1 < n; i++) {
+            if (chain[i].cols != chain[i + 1].rows) throw std::invalid_argument("chain shapes do not match");
+        }
+        // dims[i] x dims[i + 1] is the shape of matrix i
+        std::vector<int> dims;
+        for (const MatView& mat : chain) dims.push_back(mat.rows);
+        if (n) dims.push_back(chain.back().cols);
+
+        ChainPlan plan;
+        plan.count = n;
+        plan.split.assign(size_t(n) * n, 0);
+        plan.kernel.assign(size_t(n) * n, ChainKernel::Blocked);
+        std::vector<double> cost(size_t(n) * n, 0.0);
+        for (int length = 2; length <= n; length++) {
+            for (int i = 0; i + length - 1 < n; i++) {
+                int j = i + length - 1;
+                double best = -1;
+                for (int s = i; s < j; s++) {
+                    auto [kernel, step] = model.price(dims[i], dims[s + 1], dims[j + 1]);
+                    double total = cost[size_t(i) * n + s] + cost[size_t(s + 1) * n + j] + step;
+                    if (best < 0 || total < best) {
+                        best = total;
+                        plan.split[size_t(i) * n + j] = s;
+                        plan.kernel[size_t(i) * n + j] = kernel;
+                    }
+                }
+                cost[size_t(i) * n + j] = best;
+            }
+        }
+        plan.predicted_seconds = n ? cost[n - 1] : 0.0;
+        return plan;
+    }
+
+    struct ChainStats {
+        int steps = 0;
+        int buffers_allocated = 0;    // intermediates that needed fresh memory
+        int buffers_reused = 0;       // intermediates placed in a released buffer
+    };
+
+    // Intermediate storage handed back and forth between steps
+    class BufferPool {
+    public:
+        explicit BufferPool(ChainStats* stats) : stats_(stats) {}
+
+        // A buffer reshaped to rows x cols, reusing the released buffer with the most capacity
+        Mat acquire(int rows, int cols) {
+            const size_t needed = size_t(rows) * cols;
+            size_t best = free_.size();
+            for (size_t b = 0; b < free_.size(); b++) {
+                if (best == free_.size() || free_[b].matrix.capacity() > free_[best].matrix.capacity()) best = b;
+            }
+            if (best == free_.size()) {
+                if (stats_) stats_->buffers_allocated++;
+                return Mat(rows, cols);
+            }
+            Mat buffer = std::move(free_[best]);
+            free_.erase(free_.begin() + best);
+            if (stats_) (buffer.matrix.capacity() >= needed ? stats_->buffers_reused : stats_->buffers_allocated)++;
+            buffer.rows = rows;
+            buffer.cols = cols;
+            buffer.matrix.resize(needed);
+            return buffer;
+        }
+
+        void release(Mat&& buffer) { free_.push_back(std::move(buffer)); }
+
+    private:
+        ChainStats* stats_;
+        std::vector<Mat> free_;
+    };
+
+    // Product of chain[i..j] following the plan. Leaves are used in place; the product of the
+    // whole chain is the only buffer not returned to the pool.
+    Mat executeChain(const std::vector<MatView>& chain, const ChainPlan& plan, int i, int j, BufferPool& pool,
+                     const ThreadConfig& config, ChainStats* stats) {
+        int s = plan.splitOf(i, j);
+        Mat left(0, 0), right(0, 0);
+        if (s > i) left = executeChain(chain, plan, i, s, pool, config, stats);
+        if (j > s + 1) right = executeChain(chain, plan, s + 1, j, pool, config, stats);
+        MatView left_view = s > i ? MatView(left) : chain[i];
+        MatView right_view = j > s + 1 ? MatView(right) : chain[j];
+
+        Mat out = pool.acquire(left_view.rows, right_view.cols);
+        chainStep(plan.kernelOf(i, j), left_view, right_view, out, config);
+        if (stats) stats->steps++;
+        if (s > i) pool.release(std::move(left));
+        if (j > s + 1) pool.release(std::move(right));
+        return out;
+    }
+
+    Mat multiplyChain(const std::vector<MatView>& chain, const ChainPlan& plan, const ThreadConfig& config = {},
+                      ChainStats* stats = nullptr) {
+        if (chain.empty()) throw std::invalid_argument("empty chain");
+        if (chain.size() == 1) {
+            Mat copy(chain[0].rows, chain[0].cols);
+            std::copy(chain[0].matrix, chain[0].matrix + copy.matrix.size(), copy.matrix.begin());
+            return copy;
+        }
+        BufferPool pool(stats);
+        return executeChain(chain, plan, 0, static_cast<int>(chain.size()) - 1, pool, config, stats);
+    }
+
+    Mat multiplyChain(const std::vector<MatView>& chain, const ThreadConfig& config = {}, ChainStats* stats = nullptr) {
+        ChainCostModel model(config);
+        return multiplyChain(chain, planChain(chain, model), config, stats);
+    }
+
+}
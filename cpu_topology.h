@@ -0,0 +1,281 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <thread>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fstream>
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+// Placement policy for worker threads
+//  - None:     leave placement to the OS scheduler
+//  - Compact:  fill SMT siblings, then cores sharing an L2, then an L3, before moving on
+//  - Scatter:  spread workers across L3 domains and cores first, SMT siblings last
+//  - Physical: one worker per physical core, SMT siblings are never used
+enum class AffinityPolicy { None, Compact, Scatter, Physical };
+
+struct CpuInfo {
+    int id;         // logical CPU number
+    int core;       // first CPU of the SMT sibling set (unique per physical core)
+    int smt_index;  // position of this CPU among its SMT siblings
+    int package;    // physical package (socket)
+    int l2_group;   // first CPU sharing this CPU's L2
+    int l3_group;   // first CPU sharing this CPU's L3 (or package if no L3)
+};
+
+struct ThreadConfig {
+    int thread_count = 0;                     // 0 = std::thread::hardware_concurrency()
+    AffinityPolicy policy = AffinityPolicy::None;
+    std::vector<int> cpu_list;                // allowed CPUs, empty = every online CPU
+};
+
+// Runs everything on the calling thread
+const ThreadConfig SINGLE_THREAD{1, AffinityPolicy::None, {}};
+
+AffinityPolicy parseAffinityPolicy(const std::string& name) {
+    if (name == "none")     return AffinityPolicy::None;
+    if (name == "compact")  return AffinityPolicy::Compact;
+    if (name == "scatter")  return AffinityPolicy::Scatter;
+    if (name == "physical") return AffinityPolicy::Physical;
+    throw std::invalid_argument("unknown affinity policy: " + name);
+}
+
+const char* affinityPolicyName(AffinityPolicy policy) {
+    switch (policy) {
+        case AffinityPolicy::Compact:  return "compact";
+        case AffinityPolicy::Scatter:  return "scatter";
+        case AffinityPolicy::Physical: return "physical";
+        default:                       return "none";
+    }
+}
+
+// Parse the sysfs/taskset list syntax, e.g. "0-3,8,10-11"
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        std::string range = list.substr(pos, comma - pos);
+        if (!range.empty()) {
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        }
+        pos = comma + 1;
+    }
+    return cpus;
+}
+
+#ifndef _WIN32
+namespace detail {
+    std::string readSysfs(const std::string& path) {
+        std::ifstream file(path);
+        std::string value;
+        if (file.is_open()) file >> value;
+        return value;
+    }
+
+    int firstCpuOf(const std::string& list, int fallback) {
+        auto cpus = parseCpuList(list);
+        return cpus.empty() ? fallback : *std::min_element(cpus.begin(), cpus.end());
+    }
+}
+#endif
+
+std::vector<CpuInfo> getCpuTopology() {
+    std::vector<CpuInfo> topology;
+#ifdef _WIN32
+    // No sharing sets on this path: every logical CPU is treated as its own core
+    int count = static_cast<int>(std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < count; cpu++) {
+        topology.push_back({cpu, cpu, 0, 0, cpu, 0});
+    }
+#else
+    const std::string base = "/sys/devices/system/cpu/";
+    std::vector<int> online = parseCpuList(detail::readSysfs(base + "online"));
+    if (online.empty()) {
+        int count = static_cast<int>(std::thread::hardware_concurrency());
+        for (int cpu = 0; cpu < count; cpu++) online.push_back(cpu);
+    }
+
+    for (int cpu : online) {
+        std::string dir = base + "cpu" + std::to_string(cpu) + "/";
+        CpuInfo info{cpu, cpu, 0, 0, cpu, 0};
+
+        auto siblings = parseCpuList(detail::readSysfs(dir + "topology/thread_siblings_list"));
+        if (!siblings.empty()) {
+            std::sort(siblings.begin(), siblings.end());
+            info.core = siblings.front();
+            info.smt_index = static_cast<int>(std::find(siblings.begin(), siblings.end(), cpu) - siblings.begin());
+        }
+
+        std::string package = detail::readSysfs(dir + "topology/physical_package_id");
+        if (!package.empty()) info.package = std::stoi(package);
+
+        info.l2_group = info.core;
+        info.l3_group = -1;
+        for (int index = 0; ; index++) {
+            std::string cache = dir + "cache/index" + std::to_string(index) + "/";
+            std::string level = detail::readSysfs(cache + "level");
+            if (level.empty()) break;
+            std::string shared = detail::readSysfs(cache + "shared_cpu_list");
+            if (level == "2") info.l2_group = detail::firstCpuOf(shared, info.l2_group);
+            if (level == "3") info.l3_group = detail::firstCpuOf(shared, cpu);
+        }
+        if (info.l3_group < 0) info.l3_group = -1 - info.package; // distinct from any CPU id
+
+        topology.push_back(info);
+    }
+#endif
+    return topology;
+}
+
+// Online CPUs that are in allowed_cpus (every online CPU if it is empty).
+// Throws if allowed_cpus names no online CPU.
+std::vector<CpuInfo> availableCpus(const std::vector<int>& allowed_cpus = {}) {
+    std::vector<CpuInfo> cpus;
+    for (const CpuInfo& info : getCpuTopology()) {
+        if (allowed_cpus.empty() ||
+            std::find(allowed_cpus.begin(), allowed_cpus.end(), info.id) != allowed_cpus.end()) {
+            cpus.push_back(info);
+        }
+    }
+    if (cpus.empty() && !allowed_cpus.empty()) throw std::invalid_argument("none of the listed CPUs is online");
+    return cpus;
+}
+
+namespace detail {
+    std::vector<int> computeAffinityPlan(AffinityPolicy policy, int thread_count, const std::vector<int>& allowed_cpus) {
+        std::vector<int> plan;
+        std::vector<CpuInfo> cpus = availableCpus(allowed_cpus);
+        if (policy == AffinityPolicy::None || cpus.empty()) return plan;
+
+        if (policy == AffinityPolicy::Physical) {
+            cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                                      [](const CpuInfo& c) { return c.smt_index != 0; }),
+                       cpus.end());
+            if (cpus.empty()) throw std::invalid_argument("none of the listed CPUs is the first thread of a physical core");
+        }
+
+        // Compact order: neighbours in the list share as much cache as possible
+        std::sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b) {
+            if (a.package  != b.package)  return a.package  < b.package;
+            if (a.l3_group != b.l3_group) return a.l3_group < b.l3_group;
+            if (a.l2_group != b.l2_group) return a.l2_group < b.l2_group;
+            if (a.core     != b.core)     return a.core     < b.core;
+            return a.smt_index < b.smt_index;
+        });
+
+        if (policy == AffinityPolicy::Scatter) {
+            // Deal CPUs round-robin over L3 domains, taking first SMT threads of every core before any sibling
+            std::stable_sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b) {
+                return a.smt_index < b.smt_index;
+            });
+            std::vector<std::vector<CpuInfo>> domains;
+            for (const CpuInfo& info : cpus) {
+                auto it = std::find_if(domains.begin(), domains.end(), [&](const std::vector<CpuInfo>& d) {
+                    return d.front().l3_group == info.l3_group && d.front().smt_index == info.smt_index;
+                });
+                if (it == domains.end()) domains.push_back({info});
+                else it->push_back(info);
+            }
+            cpus.clear();
+            for (size_t start = 0; start < domains.size(); ) {
+                int smt = domains[start].front().smt_index;
+                size_t end = start;
+                while (end < domains.size() && domains[end].front().smt_index == smt) end++;
+                for (size_t round = 0; ; round++) {
+                    bool any = false;
+                    for (size_t d = start; d < end; d++) {
+                        if (round < domains[d].size()) { cpus.push_back(domains[d][round]); any = true; }
+                    }
+                    if (!any) break;
+                }
+                start = end;
+            }
+        }
+
+        for (int t = 0; t < thread_count; t++) {
+            plan.push_back(cpus[t % cpus.size()].id);
+        }
+        return plan;
+    }
+}
+
+// Logical CPUs (one per worker) chosen by the policy, restricted to allowed_cpus if non-empty.
+// Returns an empty list for AffinityPolicy::None: such workers are only confined to allowed_cpus
+// as a whole (see placeCurrentThread). Workers beyond the number of eligible CPUs wrap around
+// to the start of the plan. Throws if the policy leaves no eligible CPU.
+// Plans are computed from sysfs once per (policy, thread count, CPU list) and then kept for the
+// life of the process, so the threaded kernels can ask for one on every call without allocating.
+const std::vector<int>& planAffinity(AffinityPolicy policy, int thread_count,
+                                     const std::vector<int>& allowed_cpus = {}) {
+    static const std::vector<int> no_plan;
+    if (thread_count <= 0 || (policy == AffinityPolicy::None && allowed_cpus.empty())) return no_plan;
+    static std::mutex mutex;
+    static std::map<std::tuple<AffinityPolicy, int, std::vector<int>>, std::vector<int>, std::less<>> plans;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = plans.find(std::tie(policy, thread_count, allowed_cpus));
+    if (found == plans.end()) {
+        found = plans.emplace(std::make_tuple(policy, thread_count, allowed_cpus),
+                              detail::computeAffinityPlan(policy, thread_count, allowed_cpus)).first;
+    }
+    return found->second;
+}
+
+// Pin the calling thread to a single logical CPU
+bool pinCurrentThread(int cpu) {
+#ifdef _WIN32
+    if (cpu < 0 || cpu >= 64) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#else
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#endif
+}
+
+// Confine the calling thread to a set of logical CPUs, leaving placement within it to the OS
+bool restrictCurrentThread(const std::vector<int>& cpus) {
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < 64) mask |= DWORD_PTR(1) << cpu;
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#endif
+}
+
+// Place worker t: pinned to its planned CPU, or only confined to cpu_list when there is no plan
+void placeCurrentThread(const std::vector<int>& plan, int t, const std::vector<int>& cpu_list) {
+    if (!plan.empty()) pinCurrentThread(plan[t]);
+    else if (!cpu_list.empty()) restrictCurrentThread(cpu_list);
+}
+
+int resolveThreadCount(const ThreadConfig& config) {
+    if (config.thread_count > 0) return config.thread_count;
+    int hw = static_cast<int>(std::thread::hardware_concurrency());
+    return hw > 0 ? hw : 1;
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+// Fused GEMM epilogues: C = epilogue(A * B) applied to each output tile as soon as its last
+// k step is done, while the tile is still in L1, instead of in extra passes over C afterwards.
+// An epilogue is any functor with an `out_t` type and
+//     out_t operator()(int acc, int i, int j, out_t old) const
+// called once per element with the finished accumulator, its position and the destination's
+// previous value. LinearEpilogue covers alpha / beta scaling, row and column bias, an
+// activation and conversion to the output type.
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "Rec_MatMul.h"
+
+// Matrix of an arbitrary element type, for epilogues that convert the int accumulators
+template <class T>
+struct TypedMat {
+    int rows, cols;
+    std::vector<T> matrix;
+    TypedMat(int r, int c) : rows(r), cols(c), matrix(size_t(r) * c, T()) {}
+};
+
+// Writable destination of an epilogue: a Mat (int), a TypedMat or raw row-major memory
+template <class T>
+struct OutView {
+    int rows, cols;
+    T* matrix;
+    OutView(TypedMat<T>& m) : rows(m.rows), cols(m.cols), matrix(m.matrix.data()) {}
+    OutView(Mat& m) requires std::is_same_v<T, int> : rows(m.rows), cols(m.cols), matrix(m.matrix.data()) {}
+    OutView(int r, int c, T* data) : rows(r), cols(c), matrix(data) {}
+};
+
+namespace Activation {
+    struct Identity {
+        double operator()(double x) const { return x; }
+    };
+    struct ReLU {
+        double operator()(double x) const { return x > 0 ? x : 0; }
+    };
+    struct Clamp {
+        double lo, hi;
+        double operator()(double x) const { return x < lo ? lo : (x > hi ? hi : x); }
+    };
+}
+
+// Round and saturate into integral outputs, plain conversion for floating point
+template <class Out>
+Out saturateCast(double x) {
+    if constexpr (std::is_integral_v<Out>) {
+        x = std::nearbyint(x);
+        if (x <= double(std::numeric_limits<Out>::min())) return std::numeric_limits<Out>::min();
+        if (x >= double(std::numeric_limits<Out>::max())) return std::numeric_limits<Out>::max();
+        return static_cast<Out>(x);
+    } else {
+        return static_cast<Out>(x);
+    }
+}
+
+// out = convert(activation(alpha * acc + beta * old + row_bias[i] + col_bias[j]))
+template <class Out = int, class Act = Activation::Identity>
+struct LinearEpilogue {
+    using out_t = Out;
+    double alpha = 1.0, beta = 0.0;
+    const int* row_bias = nullptr;   // one per row of C, or none
+    const int* col_bias = nullptr;   // one per column of C, or none
+    Act activation{};
+
+    Out operator()(int acc, int i, int j, Out old) const {
+        double x = alpha * acc;
+        if (beta != 0.0) x += beta * double(old);
+        if (row_bias) x += row_bias[i];
+        if (col_bias) x += col_bias[j];
+        return saturateCast<Out>(activation(x));
+    }
+};
+
+// out = acc, or out = old + acc when accumulating: a plain int product into an existing buffer
+struct StoreEpilogue {
+    using out_t = int;
+    bool accumulate = false;
+    int operator()(int acc, int, int, int old) const { return accumulate ? old + acc : acc; }
+};
+
+namespace MatMath {
+
+    // checkResult for an epilogue destination: the product's shape, and no memory shared with an operand
+    template <class T>
+    void checkOut(MatView mat1, MatView mat2, OutView<T> out) {
+        if (mat1.cols != mat2.rows || out.rows != mat1.rows || out.cols != mat2.cols) {
+            throw std::invalid_argument("result shape does not match the product");
+        }
+        auto overlaps = [&](MatView operand) {
+            const char* begin = reinterpret_cast<const char*>(out.matrix);
+            const char* end = begin + size_t(out.rows) * out.cols * sizeof(T);
+            const char* op_begin = reinterpret_cast<const char*>(operand.matrix);
+            const char* op_end = op_begin + size_t(operand.rows) * operand.cols * sizeof(int);
+            return std::less<const char*>()(op_begin, end) && std::less<const char*>()(begin, op_end);
+        };
+        if (overlaps(mat1) || overlaps(mat2)) throw std::invalid_argument("result aliases an operand");
+    }
+
+    // Finished accumulators acc[r * acc_stride + c] of the tile at (i0, j0) through the epilogue
+    template <class Epi>
+    void applyEpilogue(const int* acc, int acc_stride, OutView<typename Epi::out_t> out, const Epi& epi,
+                       int i0, int i1, int j0, int j1) {
+        for (int ii = i0; ii < i1; ii++) {
+            const int* acc_row = acc + size_t(ii - i0) * acc_stride;
+            typename Epi::out_t* out_row = out.matrix + size_t(ii) * out.cols;
+            for (int jj = j0; jj < j1; jj++) out_row[jj] = epi(acc_row[jj - j0], ii, jj, out_row[jj]);
+        }
+    }
+
+    // One output tile into a private accumulator tile (i-k-j over every k block), then the epilogue
+    template <class S, class Epi>
+    void BlockedMul_epilogue_tile(MatView mat1, MatView mat2, OutView<typename Epi::out_t> out, const Epi& epi,
+                                  std::vector<int>& acc, int i0, int i1, int j0, int j1, int k_block = BLOCK_SIZE) {
+        const int width = j1 - j0;
+        std::fill(acc.begin(), acc.begin() + size_t(i1 - i0) * width, S::zero());
+        for (int k0 = 0; k0 < mat1.cols; k0 += k_block) {
+            int k1 = (std::min)(k0 + k_block, mat1.cols);
+            for (int ii = i0; ii < i1; ii++) {
+                int* acc_row = acc.data() + size_t(ii - i0) * width;
+                for (int kk = k0; kk < k1; kk++) {
+                    const int a = mat1.matrix[size_t(ii) * mat1.cols + kk];
+                    const int* b_row = mat2.matrix + size_t(kk) * mat2.cols + j0;
+                    for (int jj = 0; jj < width; jj++) acc_row[jj] = S::add(acc_row[jj], S::mul(a, b_row[jj]));
+                }
+            }
+        }
+        applyEpilogue(acc.data(), width, out, epi, i0, i1, j0, j1);
+    }
+
+    // out = epi(A * B) with block x block output tiles shared out across the workers
+    template <class S = PlusTimes, class Epi>
+    void BlockedMul_threading_epilogue(MatView mat1, MatView mat2, OutView<typename Epi::out_t> out, const Epi& epi,
+                                       const ThreadConfig& config = {}, int block = BLOCK_SIZE) {
+        checkOut(mat1, mat2, out);
+        int row_tiles = (mat1.rows + block - 1) / block;
+        int col_tiles = (mat2.cols + block - 1) / block;
+        std::atomic<int> next_tile{0};
+        runWorkers(config, [&](int) {
+            std::vector<int> acc(size_t((std::min)(block, mat1.rows)) * (std::min)(block, mat2.cols));
+            for (int tile = next_tile++; tile < row_tiles * col_tiles; tile = next_tile++) {
+                int i = (tile % row_tiles) * block, j = (tile / row_tiles) * block;
+                BlockedMul_epilogue_tile<S>(mat1, mat2, out, epi, acc, i, (std::min)(i + block, mat1.rows),
+                                            j, (std::min)(j + block, mat2.cols), block);
+            }
+        });
+    }
+
+    template <class S = PlusTimes, class Epi>
+    void BlockedMul_epilogue(MatView mat1, MatView mat2, OutView<typename Epi::out_t> out, const Epi& epi) {
+        BlockedMul_threading_epilogue<S>(mat1, mat2, out, epi, SINGLE_THREAD);
+    }
+
+    // Recursive path: the quadrants are computed by matMul as usual and the epilogue is fused
+    // into the final add of each quadrant's two halves, the last time its values are touched
+    template <class S = PlusTimes, class Epi>
+    void matMul(MatView mat1, MatView mat2, OutView<typename Epi::out_t> out, const Epi& epi) {
+        checkOut(mat1, mat2, out);
+        const int rows = mat1.rows, inner = mat1.cols, cols = mat2.cols;
+        if (rows <= 64 || inner <= 64 || cols <= 64) {
+            Mat acc(rows, cols);
+            MultiplyMat<S>(acc, mat1, mat2, 0, rows, 0, inner, 0, inner, 0, cols, 0, 0);
+            applyEpilogue(acc.matrix.data(), cols, out, epi, 0, rows, 0, cols);
+            return;
+        }
+        const int row_cuts[3] = {0, rows / 2, rows}, k_mid = inner / 2, col_cuts[3] = {0, cols / 2, cols};
+        for (int r = 0; r < 2; r++) {
+            for (int c = 0; c < 2; c++) {
+                int r0 = row_cuts[r], r1 = row_cuts[r + 1], c0 = col_cuts[c], c1 = col_cuts[c + 1];
+                Mat first(r1 - r0, c1 - c0), second(r1 - r0, c1 - c0);
+                matMul<S>(first, mat1, mat2, r0, r1, 0, k_mid, 0, k_mid, c0, c1, 0, 0);
+                matMul<S>(second, mat1, mat2, r0, r1, k_mid, inner, k_mid, inner, c0, c1, 0, 0);
+                for (int ii = r0; ii < r1; ii++) {
+                    const int* first_row = first.matrix.data() + size_t(ii - r0) * first.cols;
+                    const int* second_row = second.matrix.data() + size_t(ii - r0) * second.cols;
+                    typename Epi::out_t* out_row = out.matrix + size_t(ii) * out.cols;
+                    for (int jj = c0; jj < c1; jj++) {
+                        out_row[jj] = epi(S::add(first_row[jj - c0], second_row[jj - c0]), ii, jj, out_row[jj]);
+                    }
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+// Lazy matrix expressions over (+, *). lazy(A) * lazy(B) + lazy(C) * lazy(E) builds a tree of
+// views and nothing is computed until assign() evaluates it into a destination:
+//   - a sum writes its plain-matrix terms into the destination first, whatever their position,
+//     then adds every product term into it through the GEMM epilogue (old + acc), so A * B + C
+//     and C + A * B take the same single pass and no product is stored separately to be added;
+//   - a product whose left side is itself an expression is evaluated one panel of rows at a
+//     time: rows [r0, r1) of (X * Y) only need rows [r0, r1) of X, so (A * B) * C keeps a
+//     BLOCK_SIZE-row panel of A * B instead of the whole intermediate.
+// A product's right side is needed in full and is materialized once if it is not a plain matrix.
+// The destination may appear in the expression only as a plain-matrix term of a sum (D = C + D +
+// A * B); those terms are summed first, before anything overwrites D. assign() rejects a
+// destination overlapping a product operand, or any other term without being exactly D.
+
+#include <concepts>
+#include <stdexcept>
+#include <type_traits>
+#include "Rec_MatMul.h"
+#include "epilogue.h"
+
+namespace MatMath {
+
+    namespace expr {
+
+        struct Node {};
+
+        template <class E>
+        concept Expression = std::derived_from<E, Node>;
+
+        // A plain matrix (or a contiguous run of its rows)
+        struct Leaf : Node {
+            MatView view;
+            explicit Leaf(MatView v) : view(v) {}
+            int rows() const { return view.rows; }
+            int cols() const { return view.cols; }
+            Leaf slice(int r0, int r1) const {
+                return Leaf(MatView(r1 - r0, view.cols, view.matrix + size_t(r0) * view.cols));
+            }
+        };
+
+        template <Expression L, Expression R>
+        struct Product : Node {
+            L left;
+            R right;
+            Product(L l, R r) : left(l), right(r) {
+                if (left.cols() != right.rows()) throw std::invalid_argument("operand shapes do not match");
+            }
+            int rows() const { return left.rows(); }
+            int cols() const { return right.cols(); }
+            auto slice(int r0, int r1) const { return Product<decltype(left.slice(r0, r1)), R>(left.slice(r0, r1), right); }
+        };
+
+        template <Expression L, Expression R>
+        struct Sum : Node {
+            L left;
+            R right;
+            Sum(L l, R r) : left(l), right(r) {
+                if (left.rows() != right.rows() || left.cols() != right.cols()) {
+                    throw std::invalid_argument("summand shapes do not match");
+                }
+            }
+            int rows() const { return left.rows(); }
+            int cols() const { return left.cols(); }
+            auto slice(int r0, int r1) const {
+                return Sum<decltype(left.slice(r0, r1)), decltype(right.slice(r0, r1))>(left.slice(r0, r1), right.slice(r0, r1));
+            }
+        };
+
+        template <Expression L, Expression R>
+        Product<L, R> operator*(const L& l, const R& r) { return Product<L, R>(l, r); }
+
+        template <Expression L, Expression R>
+        Sum<L, R> operator+(const L& l, const R& r) { return Sum<L, R>(l, r); }
+
+        // Evaluation settings, and the ints allocated for intermediates (panels, materialized operands)
+        struct Context {
+            const ThreadConfig& config;
+            long long temp_ints = 0;
+        };
+
+        // Rows of `dest` receive the expression (or have it added when `accumulate` is set)
+        void evaluate(const Leaf& e, OutView<int> dest, bool accumulate, Context&) {
+            const size_t count = size_t(e.rows()) * e.cols();
+            for (size_t n = 0; n < count; n++) dest.matrix[n] = accumulate ? dest.matrix[n] + e.view.matrix[n] : e.view.matrix[n];
+        }
+
+        template <class E>
+        struct IsProduct : std::false_type {};
+        template <class L, class R>
+        struct IsProduct<Product<L, R>> : std::true_type {};
+
+        template <class E>
+        struct IsSum : std::false_type {};
+        template <class L, class R>
+        struct IsSum<Sum<L, R>> : std::true_type {};
+
+        // Term classes of a sum, in evaluation order: plain matrices that are the destination itself,
+        // the other plain matrices, then the products
+        enum class Terms { Destination, Plain, Products };
+
+        template <class E>
+        Terms termClass(const E& e, OutView<int> dest) {
+            if constexpr (IsProduct<E>::value) return Terms::Products;
+            else if constexpr (std::is_same_v<E, Leaf>) return e.view.matrix == dest.matrix ? Terms::Destination : Terms::Plain;
+            else return Terms::Plain;
+        }
+
+        // The terms of a (nested) sum in class `terms`; the first term evaluated writes the
+        // destination unless `accumulate` is already set, every later one adds into it
+        template <class E>
+        void evaluateTerms(const E& e, OutView<int> dest, bool& accumulate, Terms terms, Context& context) {
+            if constexpr (IsSum<E>::value) {
+                evaluateTerms(e.left, dest, accumulate, terms, context);
+                evaluateTerms(e.right, dest, accumulate, terms, context);
+            } else if (termClass(e, dest) == terms) {
+                evaluate(e, dest, accumulate, context);
+                accumulate = true;
+            }
+        }
+
+        template <class L, class R>
+        void evaluate(const Sum<L, R>& e, OutView<int> dest, bool accumulate, Context& context) {
+            evaluateTerms(e, dest, accumulate, Terms::Destination, context);
+            evaluateTerms(e, dest, accumulate, Terms::Plain, context);
+            evaluateTerms(e, dest, accumulate, Terms::Products, context);
+        }
+
+        template <class E>
+        MatView materialize(const E& e, Mat& storage, Context& context) {
+            if constexpr (std::is_same_v<E, Leaf>) {
+                return e.view;
+            } else {
+                storage = Mat(e.rows(), e.cols());
+                context.temp_ints += static_cast<long long>(storage.matrix.size());
+                evaluate(e, OutView<int>(storage), false, context);
+                return storage;
+            }
+        }
+
+        template <class L, class R>
+        void evaluate(const Product<L, R>& e, OutView<int> dest, bool accumulate, Context& context) {
+            Mat right_storage(0, 0);
+            MatView right = materialize(e.right, right_storage, context);
+            const StoreEpilogue store{accumulate};
+            if constexpr (std::is_same_v<L, Leaf>) {
+                BlockedMul_threading_epilogue(e.left.view, right, dest, store, context.config);
+            } else {
+                const int rows = e.rows();
+                Mat panel((std::min)(BLOCK_SIZE, rows), e.left.cols());
+                context.temp_ints += static_cast<long long>(panel.matrix.size());
+                for (int r0 = 0; r0 < rows; r0 += BLOCK_SIZE) {
+                    int r1 = (std::min)(r0 + BLOCK_SIZE, rows);
+                    OutView<int> panel_out(panel);
+                    panel_out.rows = r1 - r0;
+                    evaluate(e.left.slice(r0, r1), panel_out, false, context);
+                    OutView<int> dest_rows = dest;
+                    dest_rows.rows = r1 - r0;
+                    dest_rows.matrix += size_t(r0) * dest.cols;
+                    BlockedMul_threading_epilogue(MatView(r1 - r0, panel.cols, panel.matrix.data()), right, dest_rows, store,
+                                                  context.config);
+                }
+            }
+        }
+
+        // Whether a product operand in `e` overlaps [begin, end), or a plain term does without being
+        // exactly that range
+        template <class E>
+        bool readsDestination(const E& e, const int* begin, const int* end, bool in_product = false) {
+            if constexpr (std::is_same_v<E, Leaf>) {
+                const int* leaf_end = e.view.matrix + size_t(e.rows()) * e.cols();
+                bool overlaps = std::less<const int*>()(e.view.matrix, end) && std::less<const int*>()(begin, leaf_end);
+                return overlaps && (in_product || e.view.matrix != begin || leaf_end != end);
+            } else {
+                const bool product = in_product || IsProduct<E>::value;
+                return readsDestination(e.left, begin, end, product) || readsDestination(e.right, begin, end, product);
+            }
+        }
+    }
+
+    expr::Leaf lazy(MatView mat) { return expr::Leaf(mat); }
+
+    // Evaluate into a preallocated destination of the expression's shape. `temp_ints`, if given,
+    // receives the number of ints allocated for intermediates.
+    template <expr::Expression E>
+    void assign(Mat& dest, const E& e, const ThreadConfig& config = {}, long long* temp_ints = nullptr) {
+        if (dest.rows != e.rows() || dest.cols != e.cols()) throw std::invalid_argument("destination shape mismatch");
+        if (expr::readsDestination(e, dest.matrix.data(), dest.matrix.data() + dest.matrix.size())) {
+            throw std::invalid_argument("destination overlaps a product operand or part of a term");
+        }
+        expr::Context context{config};
+        expr::evaluate(e, OutView<int>(dest), false, context);
+        if (temp_ints) *temp_ints = context.temp_ints;
+    }
+
+    template <expr::Expression E>
+    Mat evaluate(const E& e, const ThreadConfig& config = {}) {
+        Mat result(e.rows(), e.cols());
+        assign(result, e, config);
+        return result;
+    }
+
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+// Quantized u8 x s8 -> s32 matrix multiply.
+// A is unsigned 8-bit (activations), B signed 8-bit (weights), each with a per-tensor scale or a
+// per-channel one (rows of A, columns of B). B is packed so every 32-bit lane holds 4 consecutive
+// k values of one column, the operand layout of VNNI vpdpbusd: one instruction multiplies 4 u8 by
+// 4 s8 and adds the sum into an int32 lane. The kernel is picked at run time:
+//   AVX-512 VNNI (16 columns per step) > AVX-VNNI (8) > AVX2 (8) > portable scalar.
+// The AVX2 fallback widens to 16 bits and uses vpmaddwd: vpmaddubsw would saturate its int16
+// pair sums (255 * 127 * 2 > 32767) on full-range u8 inputs and give wrong results.
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "Rec_MatMul.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define MATMUL_X86_DISPATCH 1
+#endif
+
+template <class T>
+struct QuantMat {
+    int rows, cols;
+    int kpad;                   // k dimension rounded up to a multiple of 4
+    std::vector<T> data;        // A: rows x kpad row-major; B: packed [k / 4][cols][4]
+    std::vector<float> scales;  // one per tensor, or one per channel (rows of A / columns of B)
+
+    float scale(int channel) const { return scales.size() == 1 ? scales[0] : scales[channel]; }
+};
+
+using QuantA = QuantMat<uint8_t>;
+using QuantB = QuantMat<int8_t>;
+
+enum class Int8Path { Scalar, Avx2, AvxVnni, Avx512Vnni };
+
+const char* int8PathName(Int8Path path) {
+    switch (path) {
+        case Int8Path::Avx512Vnni: return "AVX-512 VNNI";
+        case Int8Path::AvxVnni:    return "AVX-VNNI";
+        case Int8Path::Avx2:       return "AVX2";
+        default:                   return "scalar";
+    }
+}
+
+// Whether the running CPU can execute the kernel for `path`
+bool int8PathSupported(Int8Path path) {
+#ifdef MATMUL_X86_DISPATCH
+    __builtin_cpu_init();
+    switch (path) {
+        case Int8Path::Avx512Vnni: return __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw");
+        case Int8Path::AvxVnni:    return __builtin_cpu_supports("avxvnni");
+        case Int8Path::Avx2:       return __builtin_cpu_supports("avx2");
+        default:                   return true;
+    }
+#else
+    return path == Int8Path::Scalar;
+#endif
+}
+
+// Fastest supported kernel
+Int8Path detectInt8Path() {
+    for (Int8Path path : {Int8Path::Avx512Vnni, Int8Path::AvxVnni, Int8Path::Avx2}) {
+        if (int8PathSupported(path)) return path;
+    }
+    return Int8Path::Scalar;
+}
+
+// Symmetric quantization of A to u8 (negative values clamp to 0): q = round(x / scale), scale = max / 255
+QuantA quantizeA(MatView mat, bool per_row) {
+    QuantA q{mat.rows, mat.cols, (mat.cols + 3) / 4 * 4, {}, {}};
+    q.data.assign(size_t(q.rows) * q.kpad, 0);
+    q.scales.assign(per_row ? (std::max)(mat.rows, 1) : 1, 1.0f);
+    auto peak = [&](int r0, int r1) {
+        int m = 0;
+        for (int i = r0; i < r1; i++)
+            for (int k = 0; k < mat.cols; k++) m = (std::max)(m, mat.matrix[size_t(i) * mat.cols + k]);
+        return m > 0 ? m / 255.0f : 1.0f;
+    };
+    if (!per_row) q.scales[0] = peak(0, mat.rows);
+    for (int i = 0; i < mat.rows; i++) {
+        if (per_row) q.scales[i] = peak(i, i + 1);
+        float inv = 1.0f / q.scale(i);
+        for (int k = 0; k < mat.cols; k++) {
+            float v = std::round(mat.matrix[size_t(i) * mat.cols + k] * inv);
+            q.data[size_t(i) * q.kpad + k] = static_cast<uint8_t>(std::clamp(v, 0.0f, 255.0f));
+        }
+    }
+    return q;
+}
+
+// Symmetric quantization of B to s8 and VNNI packing: q = round(x / scale), scale = max|x| / 127
+QuantB quantizeB(MatView mat, bool per_column) {
+    QuantB q{mat.rows, mat.cols, (mat.rows + 3) / 4 * 4, {}, {}};
+    q.data.assign(size_t(q.kpad) * q.cols, 0);
+    q.scales.assign(per_column ? (std::max)(mat.cols, 1) : 1, 1.0f);
+    std::vector<long long> peak(q.scales.size(), 0);
+    for (int k = 0; k < mat.rows; k++) {
+        for (int j = 0; j < mat.cols; j++) {
+            long long v = std::llabs(static_cast<long long>(mat.matrix[size_t(k) * mat.cols + j]));
+            long long& p = peak[per_column ? j : 0];
+            p = (std::max)(p, v);
+        }
+    }
+    for (size_t c = 0; c < peak.size(); c++) q.scales[c] = peak[c] > 0 ? peak[c] / 127.0f : 1.0f;
+    for (int k = 0; k < mat.rows; k++) {
+        for (int j = 0; j < mat.cols; j++) {
+            float v = std::round(mat.matrix[size_t(k) * mat.cols + j] / q.scale(j));
+            q.data[(size_t(k / 4) * q.cols + j) * 4 + k % 4] = static_cast<int8_t>(std::clamp(v, -127.0f, 127.0f));
+        }
+    }
+    return q;
+}
+
+namespace MatMath {
+
+    namespace int8 {
+
+        // Columns [j0, j1) of row i: c[j] = sum over k of a[i, k] * b[k, j]
+        void rowScalar(const QuantA& a, const QuantB& b, int* c, int i, int j0, int j1) {
+            const uint8_t* a_row = a.data.data() + size_t(i) * a.kpad;
+            for (int j = j0; j < j1; j++) {
+                int sum = 0;
+                for (int g = 0; g < a.kpad / 4; g++) {
+                    const int8_t* b4 = b.data.data() + (size_t(g) * b.cols + j) * 4;
+                    for (int t = 0; t < 4; t++) sum += int(a_row[g * 4 + t]) * int(b4[t]);
+                }
+                c[j] = sum;
+            }
+        }
+
+#ifdef MATMUL_X86_DISPATCH
+        __attribute__((target("avx512f,avx512bw,avx512vnni")))
+        int rowAvx512Vnni(const QuantA& a, const QuantB& b, int* c, int i, int j0, int j1) {
+            const uint8_t* a_row = a.data.data() + size_t(i) * a.kpad;
+            int j = j0;
+            for (; j + 16 <= j1; j += 16) {
+                __m512i acc = _mm512_setzero_si512();
+                for (int g = 0; g < a.kpad / 4; g++) {
+                    int32_t a4;
+                    std::memcpy(&a4, a_row + g * 4, 4);
+                    __m512i bv = _mm512_loadu_si512(b.data.data() + (size_t(g) * b.cols + j) * 4);
+                    acc = _mm512_dpbusd_epi32(acc, _mm512_set1_epi32(a4), bv);
+                }
+                _mm512_storeu_si512(c + j, acc);
+            }
+            return j;
+        }
+
+        __attribute__((target("avx2,avxvnni")))
+        int rowAvxVnni(const QuantA& a, const QuantB& b, int* c, int i, int j0, int j1) {
+            const uint8_t* a_row = a.data.data() + size_t(i) * a.kpad;
+            int j = j0;
+            for (; j + 8 <= j1; j += 8) {
+                __m256i acc = _mm256_setzero_si256();
+                for (int g = 0; g < a.kpad / 4; g++) {
+                    int32_t a4;
+                    std::memcpy(&a4, a_row + g * 4, 4);
+                    __m256i bv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.data.data() + (size_t(g) * b.cols + j) * 4));
+                    acc = _mm256_dpbusd_avx_epi32(acc, _mm256_set1_epi32(a4), bv);
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + j), acc);
+            }
+            return j;
+        }
+
+        __attribute__((target("avx2")))
+        int rowAvx2(const QuantA& a, const QuantB& b, int* c, int i, int j0, int j1) {
+            const uint8_t* a_row = a.data.data() + size_t(i) * a.kpad;
+            int j = j0;
+            for (; j + 8 <= j1; j += 8) {
+                __m256i acc = _mm256_setzero_si256();
+                for (int g = 0; g < a.kpad / 4; g++) {
+                    int32_t a4;
+                    std::memcpy(&a4, a_row + g * 4, 4);
+                    // 4 u8 of A widened to int16 and repeated for each of the 8 columns
+                    __m256i av = _mm256_cvtepu8_epi16(_mm_set1_epi32(a4));
+                    __m256i bv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.data.data() + (size_t(g) * b.cols + j) * 4));
+                    __m256i b_lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(bv));      // columns j .. j + 3
+                    __m256i b_hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(bv, 1)); // columns j + 4 .. j + 7
+                    // vpmaddwd: adjacent int16 products summed into int32, then pairs folded to one sum per column
+                    __m256i p_lo = _mm256_madd_epi16(av, b_lo);
+                    __m256i p_hi = _mm256_madd_epi16(av, b_hi);
+                    __m256i sums = _mm256_hadd_epi32(p_lo, p_hi);
+                    acc = _mm256_add_epi32(acc, _mm256_permute4x64_epi64(sums, 0xD8));
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + j), acc);
+            }
+            return j;
+        }
+#endif
+    }
+
+    // C (int32 accumulators) = A * B, rows shared across workers, columns taken BLOCK_SIZE at a time
+    // so the packed B panel is reused from cache by every row
+    Mat Int8Mul(const QuantA& a, const QuantB& b, const ThreadConfig& config = {},
+                Int8Path path = detectInt8Path()) {
+        if (a.cols != b.rows || a.kpad != b.kpad) throw std::invalid_argument("operand shapes do not match");
+        Mat result(a.rows, b.cols);
+        std::atomic<int> next_row{0};
+        runWorkers(config, [&](int) {
+            for (int i = next_row++; i < a.rows; i = next_row++) {
+                int* c = result.matrix.data() + size_t(i) * result.cols;
+                for (int j0 = 0; j0 < b.cols; j0 += BLOCK_SIZE) {
+                    int j1 = (std::min)(j0 + BLOCK_SIZE, b.cols);
+                    int j = j0;
+#ifdef MATMUL_X86_DISPATCH
+                    switch (path) {
+                        case Int8Path::Avx512Vnni: j = int8::rowAvx512Vnni(a, b, c, i, j0, j1); break;
+                        case Int8Path::AvxVnni:    j = int8::rowAvxVnni(a, b, c, i, j0, j1); break;
+                        case Int8Path::Avx2:       j = int8::rowAvx2(a, b, c, i, j0, j1); break;
+                        default: break;
+                    }
+#endif
+                    int8::rowScalar(a, b, c, i, j, j1);
+                }
+            }
+        });
+        return result;
+    }
+
+    // Real-valued result: C[i, j] * scale_A(i) * scale_B(j)
+    std::vector<float> dequantize(const Mat& acc, const QuantA& a, const QuantB& b) {
+        std::vector<float> out(acc.matrix.size());
+        for (int i = 0; i < acc.rows; i++) {
+            for (int j = 0; j < acc.cols; j++) {
+                out[size_t(i) * acc.cols + j] = acc.matrix[size_t(i) * acc.cols + j] * a.scale(i) * b.scale(j);
+            }
+        }
+        return out;
+    }
+
+}
@@ -3,17 +3,41 @@
 #include <format> // C++20
 #include "kaizen.h" // Assuming this provides timer, print, etc.
 #include "Rec_MatMul.h" // For matMul
+#include "tile_scheduler.h" // For BlockedMul_taskgraph
+#include "summa_shm.h" // For SummaMul
+#include "ooc_matmul.h" // For BlockedMul_ooc
+#include "mat_file.h" // For MappedMat, writeMatFile
+#include "text_loader.h" // For loadTextMatrix
+#include "mat_random.h" // For fillRandom
+#include "bit_matrix.h" // For BitMat, BitMul
+#include "int8_gemm.h" // For Int8Mul
+#include "sparse_matmul.h" // For CsrMat, SpMM, AutoMul
+#include "block_sparse.h" // For TileOccupancy, BlockedMul_threading_blocksparse
+#include "syrk.h" // For SyrkBlocked, syrkRec
+#include "structured_matrix.h" // For TriMat, BandMat, BlockedMul_structured
+#include "transpose.h" // For transpose, BlockedMul_op
+#include "epilogue.h" // For LinearEpilogue, BlockedMul_threading_epilogue
+#include "expr.h" // For lazy, assign
+#include "chain.h" // For planChain, multiplyChain
+#include "matpow.h" // For matPow
+#include "async_matmul.h" // For MulPool, multiply_async
+#include "matmul_service.h" // For MatMulService, ServiceClient
+#include "result_cache.h" // For ResultCache, contentHash
+#include <csignal>
+#include <latch>
+#include <random>
+#include <memory>
 // Assuming BlockedMul and multiply are defined elsewhere
 
 using namespace MatMath;
 
 
-std::vector<int> multiply(const std::vector<int>& a, const std::vector<int>& b, int n,int m,int p) {
-    std::vector<int> result(n * n, 0);
+std::vector<int> multiply(const int* a, const int* b, int n,int m,int p) {
+    std::vector<int> result(n * m, 0);
     for (int i = 0; i < n; i++) {
         for (int j = 0; j < m; j++) {
             for (int k = 0; k < p; k++) {
-                result[i * n + j] += a[i * n + k] * b[k * n + j];
+                result[i * m + j] += a[i * p + k] * b[k * m + j];
             }
         }
     }
@@ -25,6 +49,10 @@ std::tuple<int, int, int, int> process_args(int argc, char* argv[]) {
     auto row_options = args.get_options("--rows");
     auto col_options = args.get_options("--cols");
 
+    if (args.is_present("--load")) {
+        return {0, 0, 0, 0}; // shapes come from the matrix files
+    }
+
     if (row_options.empty() || col_options.empty()) {
         zen::log("Error: --cols and/or --rows arguments are absent, using default 1024!");
         return {1024, 1024, 1024, 1024};
@@ -33,23 +61,1163 @@ std::tuple<int, int, int, int> process_args(int argc, char* argv[]) {
     return {std::stoi(row_options[0]),std::stoi(row_options[1]), std::stoi(col_options[0]),std::stoi(col_options[1])};
 }
 
+// --threads N  --cpus 0-3,8  --affinity none|compact|scatter|physical
+ThreadConfig process_thread_args(int argc, char* argv[]) {
+    zen::cmd_args args(argv, argc);
+    ThreadConfig config;
+    auto thread_options = args.get_options("--threads");
+    auto cpu_options = args.get_options("--cpus");
+    auto affinity_options = args.get_options("--affinity");
+
+    if (!thread_options.empty()) config.thread_count = std::stoi(thread_options[0]);
+    if (!cpu_options.empty()) config.cpu_list = parseCpuList(cpu_options[0]);
+    if (!affinity_options.empty()) config.policy = parseAffinityPolicy(affinity_options[0]);
+    if (config.thread_count == 0 && !config.cpu_list.empty()) {
+        config.thread_count = static_cast<int>(config.cpu_list.size());
+    }
+    try {
+        planAffinity(config.policy, resolveThreadCount(config), config.cpu_list);
+    } catch (const std::invalid_argument& error) {
+        zen::log(std::format("Error: --cpus / --affinity: {}", error.what()));
+        std::exit(1);
+    }
+    return config;
+}
+
+// Threaded blocked multiply at 1..N threads, placed on physical cores only vs. compact (SMT siblings allowed)
+void run_scaling_benchmark(MatView matrix1, MatView matrix2, const ThreadConfig& base) {
+    std::vector<CpuInfo> topology = getCpuTopology();
+    int logical = 0, physical = 0;
+    for (const CpuInfo& cpu : topology) {
+        if (!base.cpu_list.empty() &&
+            std::find(base.cpu_list.begin(), base.cpu_list.end(), cpu.id) == base.cpu_list.end()) continue;
+        logical++;
+        if (cpu.smt_index == 0) physical++;
+    }
+    int max_threads = base.thread_count > 0 ? base.thread_count : logical;
+
+    zen::print(std::format("\nThread Scaling ({} logical CPUs, {} physical cores)\n", logical, physical));
+    zen::print("+---------+-----------------+-----------------+------------+\n");
+    zen::print("| Threads | No SMT (us)     | With SMT (us)   | SMT gain   |\n");
+    zen::print("+---------+-----------------+-----------------+------------+\n");
+
+    std::vector<int> counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) counts.push_back(threads);
+    counts.push_back(max_threads);
+
+    zen::timer timer;
+    for (int threads : counts) {
+        ThreadConfig config = base;
+        config.thread_count = threads;
+
+        // Physical placement cannot use more workers than cores without doubling up
+        long long no_smt_time = -1;
+        if (threads <= physical) {
+            config.policy = AffinityPolicy::Physical;
+            timer.start();
+            MatMath::BlockedMul_threading(matrix1, matrix2, BLOCK_SIZE, config);
+            timer.stop();
+            no_smt_time = timer.duration<zen::timer::usec>().count();
+        }
+
+        config.policy = AffinityPolicy::Compact;
+        timer.start();
+        MatMath::BlockedMul_threading(matrix1, matrix2, BLOCK_SIZE, config);
+        timer.stop();
+        long long smt_time = timer.duration<zen::timer::usec>().count();
+
+        if (no_smt_time >= 0) {
+            zen::print(std::format("| {:>7} | {:>15} | {:>15} | {:>10.2f} |\n",
+                                   threads, no_smt_time, smt_time, static_cast<double>(no_smt_time) / smt_time));
+        } else {
+            zen::print(std::format("| {:>7} | {:>15} | {:>15} | {:>10} |\n", threads, "-", smt_time, "-"));
+        }
+    }
+    zen::print("+---------+-----------------+-----------------+------------+\n");
+}
+
+// 2D (output tiles only) vs. the shape heuristic's choice of K slices
+void run_decomposition_benchmark(MatView matrix1, MatView matrix2, const ThreadConfig& config) {
+    int threads = resolveThreadCount(config);
+    int k_splits = MatMath::chooseKSplits(matrix1, matrix2, BLOCK_SIZE, threads);
+
+    zen::timer timer;
+    timer.start();
+    MatMath::BlockedMul_threading_ksplit(matrix1, matrix2, BLOCK_SIZE, 1, config);
+    timer.stop();
+    long long tiles_time = timer.duration<zen::timer::usec>().count();
+
+    timer.start();
+    MatMath::BlockedMul_threading_ksplit(matrix1, matrix2, BLOCK_SIZE, k_splits, config);
+    timer.stop();
+    long long split_time = timer.duration<zen::timer::usec>().count();
+
+    zen::print(std::format("\nDecomposition ({} threads, heuristic picks {} K slice(s))\n", threads, k_splits));
+    zen::print("+----------------------+------------+\n");
+    zen::print("| Method               | Time (us)  |\n");
+    zen::print("+----------------------+------------+\n");
+    zen::print(std::format("| {:<20} | {:>10} |\n", "2D (i, j tiles)", tiles_time));
+    zen::print(std::format("| {:<20} | {:>10} |\n", std::format("3D ({} K slices)", k_splits), split_time));
+    zen::print("+----------------------+------------+\n");
+}
+
+// SUMMA on forked worker processes: compute vs. communication time per grid size
+void run_summa_benchmark(MatView matrix1, MatView matrix2, int max_processes) {
+#ifdef _WIN32
+    zen::log("Error: --summa needs fork() and POSIX shared memory, not available on Windows");
+#else
+    zen::print("\nSUMMA over worker processes (POSIX shared memory rings)\n");
+    zen::print("+-----------+-----------------+-----------------+-----------------+-----------------+------------+\n");
+    zen::print("| Processes | Total (us)      | Compute avg(us) | Comm avg (us)   | Comm max (us)   | Moved (MB) |\n");
+    zen::print("+-----------+-----------------+-----------------+-----------------+-----------------+------------+\n");
+
+    zen::timer timer;
+    for (int q = 1; q * q <= max_processes; q++) {
+        SummaStats stats;
+        timer.start();
+        MatMath::SummaMul(matrix1, matrix2, q * q, &stats);
+        timer.stop();
+        zen::print(std::format("| {:>9} | {:>15} | {:>15.0f} | {:>15.0f} | {:>15.0f} | {:>10.1f} |\n",
+                               q * q, timer.duration<zen::timer::usec>().count(),
+                               stats.compute_us_avg, stats.comm_us_avg, stats.comm_us_max,
+                               stats.bytes_sent / (1024.0 * 1024.0)));
+    }
+    zen::print("+-----------+-----------------+-----------------+-----------------+-----------------+------------+\n");
+#endif
+}
+
+// Out-of-core multiply over files in `dir` with a RAM budget for the tiles
+void run_ooc_benchmark(MatView matrix1, MatView matrix2, const std::string& dir, size_t budget_mb) {
+    FileMat file1 = FileMat::fromMat(dir + "/ooc_a.bin", matrix1);
+    FileMat file2 = FileMat::fromMat(dir + "/ooc_b.bin", matrix2);
+    FileMat result = FileMat::create(dir + "/ooc_c.bin", matrix1.rows, matrix2.cols);
+
+    OocStats stats;
+    zen::timer timer;
+    timer.start();
+    MatMath::BlockedMul_ooc(file1, file2, result, budget_mb << 20, &stats);
+    timer.stop();
+    long long ooc_time = timer.duration<zen::timer::usec>().count();
+    double seconds = ooc_time / 1e6;
+    double read_mb = stats.bytes_read / (1024.0 * 1024.0);
+    double written_mb = stats.bytes_written / (1024.0 * 1024.0);
+
+    zen::print(std::format("\nOut-of-core Multiply ({} MB budget, {}x{} tiles)\n", budget_mb, stats.tile, stats.tile));
+    zen::print("+--------------------------------+------------+\n");
+    zen::print(std::format("| {:<30} | {:>10} |\n", "Time (us)", ooc_time));
+    zen::print(std::format("| {:<30} | {:>10.1f} |\n", "Read (MB)", read_mb));
+    zen::print(std::format("| {:<30} | {:>10.1f} |\n", "Written (MB)", written_mb));
+    zen::print(std::format("| {:<30} | {:>10.1f} |\n", "I/O throughput (MB/s)", (read_mb + written_mb) / seconds));
+    zen::print("+--------------------------------+------------+\n");
+}
+
+template <class S>
+void time_semiring(const char* name, MatView matrix1, MatView matrix2) {
+    zen::timer timer;
+    timer.start();
+    MatMath::matMul<S>(matrix1, matrix2);
+    timer.stop();
+    long long recursive_time = timer.duration<zen::timer::usec>().count();
+
+    timer.start();
+    MatMath::BlockedMul<S>(matrix1, matrix2);
+    timer.stop();
+    long long blocked_time = timer.duration<zen::timer::usec>().count();
+
+    zen::print(std::format("| {:<20} | {:>15} | {:>15} |\n", name, recursive_time, blocked_time));
+}
+
+// Products mod a 31-bit prime with lazy 64-bit accumulation
+void run_modp_benchmark(MatView matrix1, MatView matrix2) {
+    const uint32_t P = 2147483629u; // largest prime below 2^31
+    using ModP = Semiring::ModP<P>;
+    Mat mod1(matrix1.rows, matrix1.cols), mod2(matrix2.rows, matrix2.cols);
+    std::copy(matrix1.matrix, matrix1.matrix + mod1.matrix.size(), mod1.matrix.begin());
+    std::copy(matrix2.matrix, matrix2.matrix + mod2.matrix.size(), mod2.matrix.begin());
+    MatMath::reduceMod<P>(mod1);
+    MatMath::reduceMod<P>(mod2);
+
+    zen::timer timer;
+    timer.start();
+    Mat recursive = MatMath::matMul<ModP>(mod1, mod2);
+    timer.stop();
+    long long recursive_time = timer.duration<zen::timer::usec>().count();
+
+    timer.start();
+    Mat blocked = MatMath::BlockedMul<ModP>(mod1, mod2);
+    timer.stop();
+    long long blocked_time = timer.duration<zen::timer::usec>().count();
+
+    zen::print(std::format("\nModular Product (mod {}{})\n", P, recursive.matrix == blocked.matrix ? "" : ", MISMATCH"));
+    zen::print("+----------------------+------------+\n");
+    zen::print("| Method               | Time (us)  |\n");
+    zen::print("+----------------------+------------+\n");
+    zen::print(std::format("| {:<20} | {:>10} |\n", "Recursive (matMul)", recursive_time));
+    zen::print(std::format("| {:<20} | {:>10} |\n", "Blocked (BlockedMul)", blocked_time));
+    zen::print("+----------------------+------------+\n");
+}
+
+// Same recursive and blocked schedules under each semiring
+void run_semiring_benchmark(MatView matrix1, MatView matrix2) {
+    zen::print("\nSemiring Products\n");
+    zen::print("+----------------------+-----------------+-----------------+\n");
+    zen::print("| Semiring             | Recursive (us)  | Blocked (us)    |\n");
+    zen::print("+----------------------+-----------------+-----------------+\n");
+    time_semiring<Semiring::PlusTimes>("(+, *)", matrix1, matrix2);
+    time_semiring<Semiring::MinPlus>("(min, +)", matrix1, matrix2);
+    time_semiring<Semiring::MaxPlus>("(max, +)", matrix1, matrix2);
+    time_semiring<Semiring::OrAnd>("(or, and)", matrix1, matrix2);
+    zen::print("+----------------------+-----------------+-----------------+\n");
+}
+
+// Boolean product on 0/1 ints (blocked, (or, and)) vs. bit-packed Four Russians
+void run_bitmat_benchmark(MatView matrix1, MatView matrix2, const ThreadConfig& config) {
+    // Odd entries become true, so roughly half of each operand is set
+    Mat bool1(matrix1.rows, matrix1.cols), bool2(matrix2.rows, matrix2.cols);
+    for (size_t n = 0; n < bool1.matrix.size(); n++) bool1.matrix[n] = matrix1.matrix[n] & 1;
+    for (size_t n = 0; n < bool2.matrix.size(); n++) bool2.matrix[n] = matrix2.matrix[n] & 1;
+    BitMat bits1 = BitMat::fromMat(bool1), bits2 = BitMat::fromMat(bool2);
+
+    zen::timer timer;
+    timer.start();
+    Mat dense = MatMath::BlockedMul<Semiring::OrAnd>(bool1, bool2);
+    timer.stop();
+    long long dense_time = timer.duration<zen::timer::usec>().count();
+
+    timer.start();
+    BitMat packed = MatMath::BitMul(bits1, bits2, config);
+    timer.stop();
+    long long packed_time = timer.duration<zen::timer::usec>().count();
+
+    bool same = packed.toMat().matrix == dense.matrix;
+    double dense_mb = (bool1.matrix.size() + bool2.matrix.size()) * sizeof(int) / (1024.0 * 1024.0);
+    double packed_mb = (bits1.bits.size() + bits2.bits.size()) * sizeof(uint64_t) / (1024.0 * 1024.0);
+
+    zen::print(std::format("\nBoolean Product ({} of {} result entries true{})\n", packed.count(),
+                           static_cast<long long>(packed.rows) * packed.cols, same ? "" : ", MISMATCH"));
+    zen::print("+----------------------+-----------------+-----------------+\n");
+    zen::print("| Method               | Time (us)       | Operands (MB)   |\n");
+    zen::print("+----------------------+-----------------+-----------------+\n");
+    zen::print(std::format("| {:<20} | {:>15} | {:>15.2f} |\n", "Blocked (or, and)", dense_time, dense_mb));
+    zen::print(std::format("| {:<20} | {:>15} | {:>15.2f} |\n", "Bit-packed (M4R)", packed_time, packed_mb));
+    zen::print("+----------------------+-----------------+-----------------+\n");
+}
+
+// Quantized u8 x s8 product on every kernel this CPU supports vs. the int32 blocked multiply
+void run_int8_benchmark(MatView matrix1, MatView matrix2, const ThreadConfig& config) {
+    QuantA qa = quantizeA(matrix1, true);
+    QuantB qb = quantizeB(matrix2, true);
+    Int8Path best = detectInt8Path();
+
+    zen::timer timer;
+    timer.start();
+    Mat exact = MatMath::BlockedMul(matrix1, matrix2);
+    timer.stop();
+    long long exact_time = timer.duration<zen::timer::usec>().count();
+
+    Mat reference = MatMath::Int8Mul(qa, qb, config, Int8Path::Scalar);
+
+    // Error of the dequantized result relative to the largest exact entry, on a sample of entries
+    // (the exact product is accumulated in double since it can overflow int32)
+    std::vector<float> approx = MatMath::dequantize(reference, qa, qb);
+    double max_error = 0, max_exact = 1;
+    size_t total = approx.size(), step = (std::max)(total / 4096, size_t(1));
+    for (size_t n = 0; n < total; n += step) {
+        size_t i = n / matrix2.cols, j = n % matrix2.cols;
+        double value = 0;
+        for (int k = 0; k < matrix1.cols; k++) {
+            value += double(matrix1.matrix[i * matrix1.cols + k]) * matrix2.matrix[size_t(k) * matrix2.cols + j];
+        }
+        max_error = (std::max)(max_error, std::abs(approx[n] - value));
+        max_exact = (std::max)(max_exact, std::abs(value));
+    }
+
+    double int32_mb = (double(matrix1.rows) * matrix1.cols + double(matrix2.rows) * matrix2.cols) * sizeof(int) / (1024.0 * 1024.0);
+    double int8_mb = (qa.data.size() + qb.data.size()) / (1024.0 * 1024.0);
+
+    zen::print(std::format("\nInt8 Product (u8 x s8 -> s32, best kernel {}, max error {:.3f}% of max |C|)\n",
+                           int8PathName(best), 100.0 * max_error / max_exact));
+    zen::print("+----------------------+-----------------+-----------------+\n");
+    zen::print("| Method               | Time (us)       | Operands (MB)   |\n");
+    zen::print("+----------------------+-----------------+-----------------+\n");
+    zen::print(std::format("| {:<20} | {:>15} | {:>15.2f} |\n", "Blocked int32", exact_time, int32_mb));
+    for (Int8Path path : {Int8Path::Scalar, Int8Path::Avx2, Int8Path::AvxVnni, Int8Path::Avx512Vnni}) {
+        if (!int8PathSupported(path)) continue;
+        timer.start();
+        Mat result = MatMath::Int8Mul(qa, qb, config, path);
+        timer.stop();
+        std::string name = std::format("int8 {}{}", int8PathName(path), result.matrix == reference.matrix ? "" : " (BAD)");
+        zen::print(std::format("| {:<20} | {:>15} | {:>15.2f} |\n", name, timer.duration<zen::timer::usec>().count(), int8_mb));
+    }
+    zen::print("+----------------------+-----------------+-----------------+\n");
+}
+
+// Density sweep of A: threaded blocked multiply vs. CSR conversion + SpMM, and what AutoMul picks
+void run_sparse_benchmark(MatView matrix1, MatView matrix2, const ThreadConfig& config) {
+    double crossover = MatMath::sparseCrossover(matrix1.rows, matrix1.cols, matrix2.cols, config);
+    zen::print(std::format("\nSparse x Dense (measured crossover density {:.1f}%)\n", 100.0 * crossover));
+    zen::print("+------------+-----------------+-----------------+-----------------+--------+\n");
+    zen::print("| Density    | Blocked (us)    | To CSR (us)     | SpMM (us)       | Auto   |\n");
+    zen::print("+------------+-----------------+-----------------+-----------------+--------+\n");
+    zen::timer timer;
+    for (double density : {0.001, 0.01, 0.02, 0.05, 0.1, 0.2, 0.3, 0.5, 1.0}) {
+        // Keep each entry of A with probability `density`, chosen by a hash of its position
+        Mat sparse(matrix1.rows, matrix1.cols);
+        uint32_t threshold = static_cast<uint32_t>(density * 4294967295.0);
+        for (size_t n = 0; n < sparse.matrix.size(); n++) {
+            if (uint32_t(n * 2654435761u) <= threshold) sparse.matrix[n] = matrix1.matrix[n];
+        }
+
+        timer.start();
+        Mat dense = MatMath::BlockedMul_threading(sparse, matrix2, BLOCK_SIZE, config);
+        timer.stop();
+        long long dense_time = timer.duration<zen::timer::usec>().count();
+
+        timer.start();
+        CsrMat csr = CsrMat::fromMat(sparse, config);
+        timer.stop();
+        long long convert_time = timer.duration<zen::timer::usec>().count();
+
+        timer.start();
+        Mat result = MatMath::SpMM(csr, matrix2, config);
+        timer.stop();
+        long long spmm_time = timer.duration<zen::timer::usec>().count();
+
+        std::string pick = sampleDensity(sparse) < crossover ? "sparse" : "dense";
+        if (result.matrix != dense.matrix) pick = "BAD";
+        zen::print(std::format("| {:>9.1f}% | {:>15} | {:>15} | {:>15} | {:<6} |\n",
+                               100.0 * csr.density(), dense_time, convert_time, spmm_time, pick));
+    }
+    zen::print("+------------+-----------------+-----------------+-----------------+--------+\n");
+}
+
+// Structured sparsity: a growing share of A's tiles zeroed, threaded blocked multiply vs. the
+// block-sparse variant with the same tile size
+void run_blocksparse_benchmark(MatView matrix1, MatView matrix2, const ThreadConfig& config) {
+    const int block = (std::min)(BLOCK_SIZE, 64);
+    zen::print(std::format("\nBlock-Sparse Product ({}x{} tiles)\n", block, block));
+    zen::print("+------------+-----------------+-----------------+-----------------+-----------+\n");
+    zen::print("| Empty A    | Blocked (us)    | Occupancy (us)  | Block-sparse    | Pairs run |\n");
+    zen::print("+------------+-----------------+-----------------+-----------------+-----------+\n");
+    zen::timer timer;
+    for (double empty : {0.0, 0.25, 0.5, 0.75, 0.9, 0.99}) {
+        // Zero each tile of A with probability `empty`, chosen by a hash of its tile coordinates
+        Mat sparse(matrix1.rows, matrix1.cols);
+        uint32_t threshold = static_cast<uint32_t>(empty * 4294967295.0);
+        for (int i = 0; i < sparse.rows; i++) {
+            for (int k = 0; k < sparse.cols; k++) {
+                uint32_t tile_hash = uint32_t((i / block) * 2654435761u) ^ uint32_t((k / block) * 2246822519u);
+                if (tile_hash * 2654435761u >= threshold || empty == 0.0) {
+                    sparse.matrix[size_t(i) * sparse.cols + k] = matrix1.matrix[size_t(i) * matrix1.cols + k];
+                }
+            }
+        }
+
+        timer.start();
+        Mat dense = MatMath::BlockedMul_threading(sparse, matrix2, block, config);
+        timer.stop();
+        long long dense_time = timer.duration<zen::timer::usec>().count();
+
+        timer.start();
+        TileOccupancy occ1 = TileOccupancy::compute(sparse, block, config);
+        TileOccupancy occ2 = TileOccupancy::compute(matrix2, block, config);
+        timer.stop();
+        long long occupancy_time = timer.duration<zen::timer::usec>().count();
+
+        timer.start();
+        Mat result = MatMath::BlockedMul_threading_blocksparse(sparse, matrix2, occ1, occ2, config);
+        timer.stop();
+        long long sparse_time = timer.duration<zen::timer::usec>().count();
+
+        long long pairs = 0, all_pairs = static_cast<long long>(occ1.tile_rows) * occ2.tile_cols * occ1.tile_cols;
+        for (int ti = 0; ti < occ1.tile_rows; ti++)
+            for (int tj = 0; tj < occ2.tile_cols; tj++) pairs += MatMath::pairCount(MatMath::tilePairs(occ1, occ2, ti, tj, sparse.cols), block);
+        std::string run = std::format("{:.1f}%", 100.0 * pairs / (std::max)(all_pairs, 1LL));
+        zen::print(std::format("| {:>9.1f}% | {:>15} | {:>15} | {:>15} | {:>9} |\n",
+                               100.0 * (1.0 - double(occ1.count()) / (std::max)(1, occ1.tile_rows * occ1.tile_cols)),
+                               dense_time, occupancy_time, sparse_time, result.matrix == dense.matrix ? run : "BAD"));
+    }
+    zen::print("+------------+-----------------+-----------------+-----------------+-----------+\n");
+}
+
+// Gram matrix A * A^T: general multiplies against A^T vs. the lower-triangle SYRK kernels
+void run_syrk_benchmark(MatView matrix1, const ThreadConfig& config) {
+    Mat transposed(matrix1.cols, matrix1.rows);
+    for (int i = 0; i < matrix1.rows; i++)
+        for (int k = 0; k < matrix1.cols; k++)
+            transposed.matrix[size_t(k) * matrix1.rows + i] = matrix1.matrix[size_t(i) * matrix1.cols + k];
+
+    zen::print(std::format("\nGram Matrix A * A^T ({}x{})\n", matrix1.rows, matrix1.rows));
+    zen::print("+----------------------+-----------------+-----------------+-----------+\n");
+    zen::print("| Method               | General (us)    | SYRK (us)       | Speedup   |\n");
+    zen::print("+----------------------+-----------------+-----------------+-----------+\n");
+    zen::timer timer;
+    auto row = [&](const char* name, auto&& general, auto&& syrk) {
+        timer.start();
+        Mat full = general();
+        timer.stop();
+        long long general_time = timer.duration<zen::timer::usec>().count();
+        timer.start();
+        Mat lower = syrk();
+        timer.stop();
+        long long syrk_time = timer.duration<zen::timer::usec>().count();
+        std::string speedup = lower.matrix == full.matrix
+            ? std::format("{:.2f}x", double(general_time) / (std::max)(syrk_time, 1LL)) : "BAD";
+        zen::print(std::format("| {:<20} | {:>15} | {:>15} | {:>9} |\n", name, general_time, syrk_time, speedup));
+    };
+    row("Recursive", [&] { return MatMath::matMul(matrix1, transposed); },
+                     [&] { return MatMath::syrkRec(matrix1); });
+    row("Blocked", [&] { return MatMath::BlockedMul(matrix1, transposed); },
+                   [&] { return MatMath::SyrkBlocked(matrix1); });
+    row(std::format("Blocked ({} thr)", resolveThreadCount(config)).c_str(),
+        [&] { return MatMath::BlockedMul_threading(matrix1, transposed, BLOCK_SIZE, config); },
+        [&] { return MatMath::SyrkBlocked_threading(matrix1, BLOCK_SIZE, config); });
+    zen::print("+----------------------+-----------------+-----------------+-----------+\n");
+}
+
+// Triangular and banded left operands (square, sized to B's rows, values taken from A) multiplied
+// densely vs. through the packed types
+void run_structured_benchmark(MatView matrix1, MatView matrix2, int bandwidth, const ThreadConfig& config) {
+    const int n = matrix2.rows;
+    const size_t source = size_t(matrix1.rows) * matrix1.cols;
+    Mat square(n, n);
+    for (size_t idx = 0; idx < square.matrix.size(); idx++) {
+        square.matrix[idx] = source ? matrix1.matrix[idx % source] : 1;
+    }
+
+    zen::print(std::format("\nStructured Left Operand ({}x{}, band width {})\n", n, n, 2 * bandwidth + 1));
+    zen::print("+----------------------+-----------------+-----------------+-----------------+\n");
+    zen::print("| Operand              | Dense (us)      | Packed (us)     | Stored (MB)     |\n");
+    zen::print("+----------------------+-----------------+-----------------+-----------------+\n");
+    zen::timer timer;
+    auto row = [&](const char* name, const auto& packed) {
+        Mat dense_operand = toDense(packed);
+        timer.start();
+        Mat dense = MatMath::BlockedMul_threading(dense_operand, matrix2, BLOCK_SIZE, config);
+        timer.stop();
+        long long dense_time = timer.duration<zen::timer::usec>().count();
+        timer.start();
+        Mat result = MatMath::BlockedMul_structured(packed, matrix2, config);
+        timer.stop();
+        long long packed_time = timer.duration<zen::timer::usec>().count();
+        std::string stored = result.matrix == dense.matrix
+            ? std::format("{:.2f}", packed.data.size() * sizeof(int) / (1024.0 * 1024.0)) : "BAD";
+        zen::print(std::format("| {:<20} | {:>15} | {:>15} | {:>15} |\n", name, dense_time, packed_time, stored));
+    };
+    row("Lower triangular", TriMat::fromMat(square, true));
+    row("Upper triangular", TriMat::fromMat(square, false));
+    row("Banded", BandMat::fromMat(square, bandwidth, bandwidth));
+    zen::print(std::format("| {:<20} | {:>15} | {:>15} | {:>15.2f} |\n", "(dense storage)", "", "",
+                           square.matrix.size() * sizeof(int) / (1024.0 * 1024.0)));
+    zen::print("+----------------------+-----------------+-----------------+-----------------+\n");
+}
+
+// Blocked vs. cache-oblivious transposes of A, then op(A) * op(B) read in stored order vs.
+// materializing the transpose first
+void run_transpose_benchmark(MatView matrix1, MatView matrix2, const ThreadConfig& config) {
+    zen::timer timer;
+    auto time_us = [&](auto&& run) {
+        timer.start();
+        run();
+        timer.stop();
+        return timer.duration<zen::timer::usec>().count();
+    };
+
+    Mat blocked(0, 0), recursive(0, 0), in_place(matrix1.rows, matrix1.cols);
+    std::copy(matrix1.matrix, matrix1.matrix + in_place.matrix.size(), in_place.matrix.begin());
+    long long blocked_time = time_us([&] { blocked = MatMath::transposeBlocked(matrix1); });
+    long long recursive_time = time_us([&] { recursive = MatMath::transpose(matrix1); });
+    long long in_place_time = time_us([&] { MatMath::transposeInPlace(in_place); });
+    bool same = recursive.matrix == blocked.matrix && in_place.matrix == blocked.matrix;
+
+    zen::print(std::format("\nTranspose ({}x{}{})\n", matrix1.rows, matrix1.cols, same ? "" : ", MISMATCH"));
+    zen::print("+--------------------------------+------------+\n");
+    zen::print("| Method                         | Time (us)  |\n");
+    zen::print("+--------------------------------+------------+\n");
+    zen::print(std::format("| {:<30} | {:>10} |\n", "Blocked (32x32 tiles)", blocked_time));
+    zen::print(std::format("| {:<30} | {:>10} |\n", "Cache-oblivious out-of-place", recursive_time));
+    zen::print(std::format("| {:<30} | {:>10} |\n", "Cache-oblivious in-place", in_place_time));
+    zen::print("+--------------------------------+------------+\n");
+
+    // Operands stored transposed, so op(.) recovers the original A and B
+    Mat reference = MatMath::BlockedMul_threading(matrix1, matrix2, BLOCK_SIZE, config);
+    Mat stored1 = MatMath::transpose(matrix1), stored2 = MatMath::transpose(matrix2);
+
+    zen::print("\nop(A) * op(B)\n");
+    zen::print("+----------------------+-----------------+-----------------+\n");
+    zen::print("| Product              | Transpose + mul | Native op (us)  |\n");
+    zen::print("+----------------------+-----------------+-----------------+\n");
+    auto row = [&](const char* name, MatView a, Op op1, MatView b, Op op2) {
+        Mat materialized(0, 0), native(0, 0);
+        long long materialized_time = time_us([&] {
+            Mat a_copy = op1 == Op::T ? MatMath::transpose(a) : Mat(0, 0);
+            Mat b_copy = op2 == Op::T ? MatMath::transpose(b) : Mat(0, 0);
+            materialized = MatMath::BlockedMul_threading(op1 == Op::T ? MatView(a_copy) : a,
+                                                         op2 == Op::T ? MatView(b_copy) : b, BLOCK_SIZE, config);
+        });
+        long long native_time = time_us([&] { native = MatMath::BlockedMul_threading_op(a, op1, b, op2, config); });
+        std::string native_text = native.matrix == reference.matrix && materialized.matrix == reference.matrix
+            ? std::to_string(native_time) : "BAD";
+        zen::print(std::format("| {:<20} | {:>15} | {:>15} |\n", name, materialized_time, native_text));
+    };
+    row("A * B^T", matrix1, Op::N, stored2, Op::T);
+    row("A^T * B", stored1, Op::T, matrix2, Op::N);
+    row("A^T * B^T", stored1, Op::T, stored2, Op::T);
+    zen::print("+----------------------+-----------------+-----------------+\n");
+}
+
+// C = relu(0.5 * A * B + C + row bias + column bias) as float: separate passes after the multiply
+// vs. the epilogue fused into the blocked and recursive multiplies
+void run_epilogue_benchmark(MatView matrix1, MatView matrix2, const ThreadConfig& config) {
+    std::vector<int> row_bias(matrix1.rows), col_bias(matrix2.cols);
+    for (int i = 0; i < matrix1.rows; i++) row_bias[i] = i % 17 - 8;
+    for (int j = 0; j < matrix2.cols; j++) col_bias[j] = j % 13 - 6;
+    LinearEpilogue<float, Activation::ReLU> epilogue;
+    epilogue.alpha = 0.5;
+    epilogue.beta = 1.0;
+    epilogue.row_bias = row_bias.data();
+    epilogue.col_bias = col_bias.data();
+
+    TypedMat<float> initial(matrix1.rows, matrix2.cols);
+    for (size_t n = 0; n < initial.matrix.size(); n++) initial.matrix[n] = float(n % 101);
+
+    zen::timer timer;
+    auto unfused = [&](auto&& multiply) {
+        TypedMat<float> out = initial;
+        timer.start();
+        Mat product = multiply();
+        for (int i = 0; i < out.rows; i++) {
+            for (int j = 0; j < out.cols; j++) {
+                float& c = out.matrix[size_t(i) * out.cols + j];
+                c = epilogue(product.matrix[size_t(i) * out.cols + j], i, j, c);
+            }
+        }
+        timer.stop();
+        return std::pair{timer.duration<zen::timer::usec>().count(), out};
+    };
+    auto fused = [&](auto&& multiply) {
+        TypedMat<float> out = initial;
+        timer.start();
+        multiply(out);
+        timer.stop();
+        return std::pair{timer.duration<zen::timer::usec>().count(), out};
+    };
+
+    zen::print("\nFused Epilogue (float C = relu(0.5 * A * B + C + biases))\n");
+    zen::print("+----------------------+-----------------+-----------------+\n");
+    zen::print("| Path                 | Separate (us)   | Fused (us)      |\n");
+    zen::print("+----------------------+-----------------+-----------------+\n");
+    auto row = [&](const std::string& name, auto separate, auto together) {
+        std::string fused_text = together.second.matrix == separate.second.matrix ? std::to_string(together.first) : "BAD";
+        zen::print(std::format("| {:<20} | {:>15} | {:>15} |\n", name, separate.first, fused_text));
+    };
+    row("Recursive",
+        unfused([&] { return MatMath::matMul(matrix1, matrix2); }),
+        fused([&](TypedMat<float>& out) { MatMath::matMul(matrix1, matrix2, out, epilogue); }));
+    row(std::format("Blocked ({} thr)", resolveThreadCount(config)),
+        unfused([&] { return MatMath::BlockedMul_threading(matrix1, matrix2, BLOCK_SIZE, config); }),
+        fused([&](TypedMat<float>& out) { MatMath::BlockedMul_threading_epilogue(matrix1, matrix2, out, epilogue, config); }));
+    zen::print("+----------------------+-----------------+-----------------+\n");
+}
+
+// Chained expressions evaluated eagerly (a Mat per intermediate) vs. lazily into a preallocated D
+void run_expr_benchmark(MatView matrix1, MatView matrix2, const ThreadConfig& config) {
+    using MatMath::lazy;
+    // Second pair of operands with the same shapes, and B^T so that (A * B) * B^T is defined
+    Mat other1(matrix1.rows, matrix1.cols), other2(matrix2.rows, matrix2.cols), back(matrix2.cols, matrix2.rows);
+    for (size_t n = 0; n < other1.matrix.size(); n++) other1.matrix[n] = int(n % 7) - 3;
+    for (size_t n = 0; n < other2.matrix.size(); n++) other2.matrix[n] = int(n % 5) - 2;
+    for (int k = 0; k < matrix2.rows; k++)
+        for (int j = 0; j < matrix2.cols; j++) back.matrix[size_t(j) * back.cols + k] = matrix2.matrix[size_t(k) * matrix2.cols + j];
+
+    zen::timer timer;
+    auto mb = [](long long ints) { return ints * sizeof(int) / (1024.0 * 1024.0); };
+
+    zen::print("\nLazy Expressions\n");
+    zen::print("+----------------------+-----------------+-----------------+-----------------+-----------------+\n");
+    zen::print("| Expression           | Eager (us)      | Temps (MB)      | Lazy (us)       | Temps (MB)      |\n");
+    zen::print("+----------------------+-----------------+-----------------+-----------------+-----------------+\n");
+
+    // D = A * B + C * E
+    {
+        timer.start();
+        Mat ab = MatMath::BlockedMul_threading(matrix1, matrix2, BLOCK_SIZE, config);
+        Mat ce = MatMath::BlockedMul_threading(other1, other2, BLOCK_SIZE, config);
+        Mat eager(ab.rows, ab.cols);
+        for (size_t n = 0; n < eager.matrix.size(); n++) eager.matrix[n] = ab.matrix[n] + ce.matrix[n];
+        timer.stop();
+        long long eager_time = timer.duration<zen::timer::usec>().count();
+
+        Mat lazy_result(ab.rows, ab.cols);
+        long long lazy_temps = 0;
+        timer.start();
+        MatMath::assign(lazy_result, lazy(matrix1) * lazy(matrix2) + lazy(other1) * lazy(other2), config, &lazy_temps);
+        timer.stop();
+        std::string lazy_time = lazy_result.matrix == eager.matrix ? std::to_string(timer.duration<zen::timer::usec>().count()) : "BAD";
+        zen::print(std::format("| {:<20} | {:>15} | {:>15.2f} | {:>15} | {:>15.2f} |\n", "A*B + C*E", eager_time,
+                               mb(2LL * ab.matrix.size()), lazy_time, mb(lazy_temps)));
+    }
+
+    // D = A * B + C, C the shape of the product
+    {
+        Mat bias(matrix1.rows, matrix2.cols);
+        for (size_t n = 0; n < bias.matrix.size(); n++) bias.matrix[n] = int(n % 11) - 5;
+        timer.start();
+        Mat eager = MatMath::BlockedMul_threading(matrix1, matrix2, BLOCK_SIZE, config);
+        for (size_t n = 0; n < eager.matrix.size(); n++) eager.matrix[n] += bias.matrix[n];
+        timer.stop();
+        long long eager_time = timer.duration<zen::timer::usec>().count();
+
+        Mat lazy_result(eager.rows, eager.cols);
+        long long lazy_temps = 0;
+        timer.start();
+        MatMath::assign(lazy_result, lazy(matrix1) * lazy(matrix2) + lazy(bias), config, &lazy_temps);
+        timer.stop();
+        std::string lazy_time = lazy_result.matrix == eager.matrix ? std::to_string(timer.duration<zen::timer::usec>().count()) : "BAD";
+        zen::print(std::format("| {:<20} | {:>15} | {:>15.2f} | {:>15} | {:>15.2f} |\n", "A*B + C", eager_time, 0.0, lazy_time,
+                               mb(lazy_temps)));
+    }
+
+    // D = (A * B) * B^T
+    {
+        timer.start();
+        Mat ab = MatMath::BlockedMul_threading(matrix1, matrix2, BLOCK_SIZE, config);
+        Mat eager = MatMath::BlockedMul_threading(ab, back, BLOCK_SIZE, config);
+        timer.stop();
+        long long eager_time = timer.duration<zen::timer::usec>().count();
+
+        Mat lazy_result(matrix1.rows, back.cols);
+        long long lazy_temps = 0;
+        timer.start();
+        MatMath::assign(lazy_result, (lazy(matrix1) * lazy(matrix2)) * lazy(back), config, &lazy_temps);
+        timer.stop();
+        std::string lazy_time = lazy_result.matrix == eager.matrix ? std::to_string(timer.duration<zen::timer::usec>().count()) : "BAD";
+        zen::print(std::format("| {:<20} | {:>15} | {:>15.2f} | {:>15} | {:>15.2f} |\n", "(A*B) * B^T", eager_time,
+                               mb(ab.matrix.size()), lazy_time, mb(lazy_temps)));
+    }
+    zen::print("+----------------------+-----------------+-----------------+-----------------+-----------------+\n");
+}
+
+// Chain of mixed shapes built around A's rows and B's columns: left-to-right order vs. the plan
+void run_chain_benchmark(MatView matrix1, MatView matrix2, const ThreadConfig& config) {
+    const int wide = matrix1.rows, tall = matrix2.cols;
+    const std::vector<int> dims = {wide, 12, tall, 6, wide, 24, tall, 3, wide};
+    std::vector<Mat> storage;
+    for (size_t m = 0; m + 1 < dims.size(); m++) {
+        storage.emplace_back(dims[m], dims[m + 1]);
+        fillRandom(storage.back(), 45, static_cast<uint32_t>(m), -2, 3, config);
+    }
+    std::vector<MatView> chain(storage.begin(), storage.end());
+
+    zen::timer timer;
+    timer.start();
+    Mat ordered = MatMath::BlockedMul_threading(chain[0], chain[1], BLOCK_SIZE, config);
+    for (size_t m = 2; m < chain.size(); m++) ordered = MatMath::BlockedMul_threading(ordered, chain[m], BLOCK_SIZE, config);
+    timer.stop();
+    long long ordered_time = timer.duration<zen::timer::usec>().count();
+
+    timer.start();
+    MatMath::ChainCostModel model(config);
+    MatMath::ChainPlan plan = MatMath::planChain(chain, model);
+    timer.stop();
+    long long plan_time = timer.duration<zen::timer::usec>().count();
+
+    MatMath::ChainStats stats;
+    timer.start();
+    Mat planned = MatMath::multiplyChain(chain, plan, config, &stats);
+    timer.stop();
+    long long planned_time = timer.duration<zen::timer::usec>().count();
+
+    std::string shapes;
+    for (size_t m = 0; m + 1 < dims.size(); m++) shapes += std::format("{}{}x{}", m ? " " : "", dims[m], dims[m + 1]);
+    zen::print(std::format("\nMatrix Chain ({}{})\n", shapes, planned.matrix == ordered.matrix ? "" : ", MISMATCH"));
+    zen::print(std::format("Plan: {}\n", plan.describe()));
+    zen::print("+--------------------------------+------------+\n");
+    zen::print("| Step                           | Time (us)  |\n");
+    zen::print("+--------------------------------+------------+\n");
+    zen::print(std::format("| {:<30} | {:>10} |\n", "Left to right (blocked)", ordered_time));
+    zen::print(std::format("| {:<30} | {:>10} |\n", std::format("Planning ({} probes)", model.probes()), plan_time));
+    zen::print(std::format("| {:<30} | {:>10} |\n", "Planned, predicted", static_cast<long long>(plan.predicted_seconds * 1e6)));
+    zen::print(std::format("| {:<30} | {:>10} |\n", "Planned, measured", planned_time));
+    zen::print("+--------------------------------+------------+\n");
+    zen::print(std::format("{} steps, {} intermediate buffers allocated, {} reused\n",
+                           stats.steps, stats.buffers_allocated, stats.buffers_reused));
+}
+
+// k-hop shortest paths as a (min, +) power of an edge-weight matrix taken from A: a directed
+// operand (general squaring) and its symmetrized undirected version (SYRK squaring), each against
+// repeated squaring that allocates a fresh product per step
+void run_matpow_benchmark(MatView matrix1, unsigned long long power, const ThreadConfig& config) {
+    using Semiring::MinPlus;
+    const int n = (std::min)(matrix1.rows, matrix1.cols);
+    Mat directed(n, n), undirected(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int w = std::abs(matrix1.matrix[size_t(i) * matrix1.cols + j]) % 9;
+            directed.matrix[size_t(i) * n + j] = i == j ? 0 : (w < 3 ? MinPlus::INF : w);
+        }
+    }
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            undirected.matrix[size_t(i) * n + j] = directed.matrix[size_t((std::max)(i, j)) * n + (std::min)(i, j)];
+
+    zen::print(std::format("\nMatrix Power A^{} over (min, +) ({}x{})\n", power, n, n));
+    zen::print("+-------------------+-----------+-------------------+-----------------+-----------------+-----------+\n");
+    zen::print("| Operand           | Squarings | Per squaring (us) | Allocating (us) | Ping-pong (us)  | Speedup   |\n");
+    zen::print("+-------------------+-----------+-------------------+-----------------+-----------------+-----------+\n");
+    zen::timer timer;
+    auto row = [&](const char* name, MatView operand) {
+        timer.start();
+        Mat square(n, n), naive = MatMath::identityMat<MinPlus>(n);
+        std::copy(operand.matrix, operand.matrix + square.matrix.size(), square.matrix.begin());
+        bool started = false;
+        for (unsigned long long k = power; k; k >>= 1) {
+            if (k & 1) {
+                naive = started ? MatMath::BlockedMul_threading<MinPlus>(naive, square, BLOCK_SIZE, config) : square;
+                started = true;
+            }
+            if (k > 1) square = MatMath::BlockedMul_threading<MinPlus>(square, square, BLOCK_SIZE, config);
+        }
+        timer.stop();
+        long long naive_time = timer.duration<zen::timer::usec>().count();
+
+        MatMath::MatPowStats stats;
+        timer.start();
+        Mat result = MatMath::matPow<MinPlus>(operand, power, config, &stats);
+        timer.stop();
+        long long pow_time = timer.duration<zen::timer::usec>().count();
+
+        long long squaring_total = 0;
+        for (long long us : stats.squaring_us) squaring_total += us;
+        std::string speedup = result.matrix == naive.matrix
+            ? std::format("{:.2f}x", double(naive_time) / (std::max)(pow_time, 1LL)) : "BAD";
+        zen::print(std::format("| {:<17} | {:>9} | {:>17} | {:>15} | {:>15} | {:>9} |\n",
+                               std::format("{}{}", name, stats.symmetric ? " (SYRK)" : ""), stats.squarings,
+                               stats.squarings ? squaring_total / stats.squarings : 0, naive_time, pow_time, speedup));
+    };
+    row("Directed", directed);
+    row("Undirected", undirected);
+    zen::print("+-------------------+-----------+-------------------+-----------------+-----------------+-----------+\n");
+}
+
+// Many multiplies of one shape through the allocating entry points vs. the ones writing into a
+// caller-provided result (or recycling one by move) with a MulWorkspace; the into loops must keep
+// one result buffer throughout. Every loop runs five rounds and reports its fastest, per call,
+// so the speedup column is not one noisy sample. 128 x 128 is large enough for matMul to recurse.
+void run_inplace_benchmark(MatView matrix1, MatView matrix2, int iterations, const ThreadConfig& config) {
+    const int n = (std::min)({matrix1.rows, matrix1.cols, matrix2.rows, matrix2.cols, 128});
+    Mat a(n, n), b(n, n);
+    for (int i = 0; i < n; i++) {
+        std::copy_n(matrix1.matrix + size_t(i) * matrix1.cols, n, a.matrix.begin() + size_t(i) * n);
+        std::copy_n(matrix2.matrix + size_t(i) * matrix2.cols, n, b.matrix.begin() + size_t(i) * n);
+    }
+
+    const int rounds = 5;
+    zen::print(std::format("\nRepeated Multiply ({}x{}, best of {} x {} iterations)\n", n, n, rounds, iterations));
+    zen::print("+------------------------------+-----------------+-----------------+-----------+--------------+\n");
+    zen::print("| Method                       | Allocating (us) | Into (us)       | Speedup   | Buffer       |\n");
+    zen::print("+------------------------------+-----------------+-----------------+-----------+--------------+\n");
+    zen::timer timer;
+    // Fastest round's time per call
+    auto best = [&](auto&& call) {
+        double fastest = -1;
+        for (int round = 0; round < rounds; round++) {
+            timer.start();
+            for (int it = 0; it < iterations; it++) call();
+            timer.stop();
+            double us = double(timer.duration<zen::timer::usec>().count()) / iterations;
+            if (fastest < 0 || us < fastest) fastest = us;
+        }
+        return fastest;
+    };
+    MulWorkspace workspace;
+    auto row = [&](const std::string& name, auto&& allocating, auto&& into, auto&& accumulate) {
+        Mat expected(0, 0);
+        double alloc_time = best([&] { expected = allocating(); });
+
+        Mat result(n, n);
+        into(result);  // sizes the workspace
+        const int* storage = result.matrix.data();
+        double into_time = best([&] { into(result); });
+        bool stable = result.matrix.data() == storage;
+
+        bool correct = result.matrix == expected.matrix;
+        accumulate(result);
+        for (size_t idx = 0; idx < result.matrix.size(); idx++) correct = correct && result.matrix[idx] == 2 * expected.matrix[idx];
+        zen::print(std::format("| {:<28} | {:>15.1f} | {:>15.1f} | {:>9} | {:<12} |\n", name, alloc_time, into_time,
+                               correct ? std::format("{:.2f}x", alloc_time / (std::max)(into_time, 0.1)) : "BAD",
+                               stable ? "reused" : "reallocated"));
+    };
+    row("Recursive (matMul)", [&] { return MatMath::matMul(a, b); },
+        [&](Mat& c) { MatMath::matMul(a, b, c, Update::Overwrite, &workspace); },
+        [&](Mat& c) { MatMath::matMul(a, b, c, Update::Accumulate, &workspace); });
+    row("Blocked (BlockedMul)", [&] { return MatMath::BlockedMul(a, b); },
+        [&](Mat& c) { MatMath::BlockedMul(a, b, c); },
+        [&](Mat& c) { MatMath::BlockedMul(a, b, c, Update::Accumulate); });
+    std::string threaded = std::format("Blocked ({} thr)", resolveThreadCount(config));
+    row(threaded, [&] { return MatMath::BlockedMul_threading(a, b, BLOCK_SIZE, config); },
+        [&](Mat& c) { MatMath::BlockedMul_threading(a, b, c, BLOCK_SIZE, config, Update::Overwrite, &workspace); },
+        [&](Mat& c) { MatMath::BlockedMul_threading(a, b, c, BLOCK_SIZE, config, Update::Accumulate, &workspace); });
+    row(threaded + ", recycled", [&] { return MatMath::BlockedMul_threading(a, b, BLOCK_SIZE, config); },
+        [&](Mat& c) { c = MatMath::BlockedMul_threading(a, b, std::move(c), BLOCK_SIZE, config, &workspace); },
+        [&](Mat& c) { MatMath::BlockedMul_threading(a, b, c, BLOCK_SIZE, config, Update::Accumulate, &workspace); });
+    zen::print("+------------------------------+-----------------+-----------------+-----------+--------------+\n");
+}
+
+// Awaits one asynchronous product and records when it became available
+MatMath::Detached await_product(MatMath::MulFuture future, std::chrono::steady_clock::time_point start,
+                                long long* done_us, std::latch* finished) {
+    co_await future;
+    *done_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    finished->count_down();
+}
+
+// One large product (A * B) followed by many small ones, submitted at once to a pool under each
+// fairness policy (small jobs awaited by coroutines, the large one through a continuation), vs.
+// issuing the same multiplies one blocking call at a time. Both sides use the same kernel block,
+// so the table compares scheduling only.
+void run_async_benchmark(MatView matrix1, MatView matrix2, int small_jobs, const ThreadConfig& config) {
+    const int n = (std::min)({matrix1.rows, matrix1.cols, matrix2.cols, 64});
+    const int block = (std::min)(BLOCK_SIZE, MatMath::MulPool::DEFAULT_TILE);
+    Mat small_a(n, n), small_b(n, n);
+    for (int i = 0; i < n; i++) {
+        std::copy_n(matrix1.matrix + size_t(i) * matrix1.cols, n, small_a.matrix.begin() + size_t(i) * n);
+        std::copy_n(matrix2.matrix + size_t(i) * matrix2.cols, n, small_b.matrix.begin() + size_t(i) * n);
+    }
+    auto since = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    zen::print(std::format("\nAsynchronous Jobs (1 x {}x{}x{}, then {} x {}x{}x{}, {} workers, block {})\n", matrix1.rows,
+                           matrix1.cols, matrix2.cols, small_jobs, n, n, n, resolveThreadCount(config), block));
+    zen::print("+----------------------+------------+-----------------+-----------------+------------+\n");
+    zen::print("| Schedule             | Total (us) | Small mean (us) | Small max (us)  | Large (us) |\n");
+    zen::print("+----------------------+------------+-----------------+-----------------+------------+\n");
+    auto row = [&](const std::string& name, long long total, const std::vector<long long>& small_done, long long large_done) {
+        long long sum = 0, worst = 0;
+        for (long long us : small_done) { sum += us; worst = (std::max)(worst, us); }
+        zen::print(std::format("| {:<20} | {:>10} | {:>15} | {:>15} | {:>10} |\n", name, total,
+                               small_done.empty() ? 0 : sum / static_cast<long long>(small_done.size()), worst, large_done));
+    };
+
+    std::vector<long long> small_done(small_jobs);
+    auto start = std::chrono::steady_clock::now();
+    Mat large_expected = MatMath::BlockedMul_threading(matrix1, matrix2, block, config);
+    long long large_done = since(start);
+    Mat small_expected(0, 0);
+    for (int job = 0; job < small_jobs; job++) {
+        small_expected = MatMath::BlockedMul_threading(small_a, small_b, block, config);
+        small_done[job] = since(start);
+    }
+    row("Blocking calls", since(start), small_done, large_done);
+
+    for (Fairness fairness : {Fairness::Fifo, Fairness::RoundRobin, Fairness::SmallFirst}) {
+        MatMath::MulPool pool(config, fairness);
+        std::vector<MatMath::MulFuture> small;
+        std::latch finished(small_jobs + 1);
+        start = std::chrono::steady_clock::now();
+        MatMath::MulFuture large = MatMath::multiply_async(matrix1, matrix2, pool);
+        large.then([&](const Mat&) { large_done = since(start); finished.count_down(); });
+        for (int job = 0; job < small_jobs; job++) {
+            small.push_back(MatMath::multiply_async(small_a, small_b, pool));
+            await_product(small.back(), start, &small_done[job], &finished);
+        }
+        finished.wait();
+        long long total = since(start);
+        bool correct = large.get().matrix == large_expected.matrix;
+        for (const auto& future : small) correct = correct && future.get().matrix == small_expected.matrix;
+        row(std::format("Pool, {}{}", fairnessName(fairness), correct ? "" : " BAD"), total, small_done, large_done);
+    }
+    zen::print("+----------------------+------------+-----------------+-----------------+------------+\n");
+}
+
+// Non-empty buckets of a daemon latency histogram, one line each
+void print_latency_histogram(const char* name, const uint64_t* counts) {
+    uint64_t total = 0;
+    for (int b = 0; b < LatencyHistogram::BUCKETS; b++) total += counts[b];
+    zen::print(std::format("{} latency ({} requests)\n", name, total));
+    for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+        if (!counts[b]) continue;
+        zen::print(std::format("  {:>9} - {:>9} us | {:>7} | {}\n", b ? 1LL << b : 0, 1LL << (b + 1), counts[b],
+                               std::string(static_cast<size_t>(40.0 * counts[b] / total + 0.5), '#')));
+    }
+}
+
+#ifndef _WIN32
+MatMath::MatMulService* active_service = nullptr;
+
+// --serve PATH: run as a daemon until SIGINT / SIGTERM or a Shutdown request
+int run_service(const std::string& socket_path, const ThreadConfig& config) {
+    MatMath::ServiceConfig service_config;
+    service_config.socket_path = socket_path;
+    service_config.threads = config;
+    MatMath::MatMulService service(service_config);
+    active_service = &service;
+    auto stop = [](int) { if (active_service) active_service->stop(); };
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+    zen::print(std::format("Serving on {} with {} workers\n", socket_path, resolveThreadCount(config)));
+    service.run();
+    active_service = nullptr;
+
+    uint64_t batched[LatencyHistogram::BUCKETS], direct[LatencyHistogram::BUCKETS];
+    for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+        batched[b] = service.batchedLatency().counts[b];
+        direct[b] = service.directLatency().counts[b];
+    }
+    zen::print(std::format("{} requests in {} batches\n", service.requests(), service.batches()));
+    print_latency_histogram("Batched", batched);
+    print_latency_histogram("Direct", direct);
+    return 0;
+}
+#endif
+
+// Small multiplies through an in-process daemon on a temporary socket: one request at a time vs.
+// pipelined (so same-shape requests coalesce into batches), then A * B as one large request, each
+// against calling the kernel directly
+void run_service_benchmark(MatView matrix1, MatView matrix2, int requests, const ThreadConfig& config) {
+#ifdef _WIN32
+    zen::log("Error: --service needs Unix domain sockets and POSIX shared memory, not available on Windows");
+#else
+    const int n = (std::min)({matrix1.rows, matrix1.cols, matrix2.cols, 32});
+    Mat small_a(n, n), small_b(n, n);
+    for (int i = 0; i < n; i++) {
+        std::copy_n(matrix1.matrix + size_t(i) * matrix1.cols, n, small_a.matrix.begin() + size_t(i) * n);
+        std::copy_n(matrix2.matrix + size_t(i) * matrix2.cols, n, small_b.matrix.begin() + size_t(i) * n);
+    }
+    std::vector<std::unique_ptr<MatMath::SharedOperands>> operands;
+    for (int r = 0; r < requests; r++) {
+        operands.push_back(std::make_unique<MatMath::SharedOperands>(n, n, n));
+        std::copy(small_a.matrix.begin(), small_a.matrix.end(), operands.back()->a());
+        std::copy(small_b.matrix.begin(), small_b.matrix.end(), operands.back()->b());
+    }
+    MatMath::SharedOperands large(matrix1.rows, matrix1.cols, matrix2.cols);
+    std::copy(matrix1.matrix, matrix1.matrix + size_t(matrix1.rows) * matrix1.cols, large.a());
+    std::copy(matrix2.matrix, matrix2.matrix + size_t(matrix2.rows) * matrix2.cols, large.b());
+
+    MatMath::ServiceConfig service_config;
+    service_config.socket_path = std::format("/tmp/matmul_service_{}.sock", getpid());
+    service_config.threads = config;
+    MatMath::MatMulService service(service_config);
+    std::thread daemon([&] { service.run(); });
+    MatMath::ServiceClient client(service_config.socket_path);
+
+    zen::print(std::format("\nMultiply Service ({} x {}x{}x{} requests, then {}x{}x{})\n", requests, n, n, n,
+                           matrix1.rows, matrix1.cols, matrix2.cols));
+    zen::print("+--------------------------------+------------+-----------------+------------+\n");
+    zen::print("| Method                         | Total (us) | Per request (us)| Batches    |\n");
+    zen::print("+--------------------------------+------------+-----------------+------------+\n");
+    zen::timer timer;
+    auto row = [&](const std::string& name, long long total, int count, const std::string& batches) {
+        zen::print(std::format("| {:<30} | {:>10} | {:>15.1f} | {:>10} |\n", name, total, double(total) / (std::max)(count, 1), batches));
+    };
+
+    // In-process rows run the daemon's kernel at the daemon's block, so the table measures transport and batching
+    const int block = (std::min)(BLOCK_SIZE, MatMath::MulPool::DEFAULT_TILE);
+    auto in_process = [&](MatView a, MatView b, Mat& c) {
+        MatMath::BlockedMul_threading_epilogue(a, b, OutView<int>(c), StoreEpilogue{}, config, block);
+    };
+    Mat small_expected(n, n);
+    timer.start();
+    for (int r = 0; r < requests; r++) in_process(small_a, small_b, small_expected);
+    timer.stop();
+    row("Small, in-process", timer.duration<zen::timer::usec>().count(), requests, "-");
+
+    auto check = [&](int first, int count) {
+        bool correct = true;
+        for (int r = first; r < first + count; r++) {
+            MatView c = operands[r]->c();
+            correct = correct && std::equal(c.matrix, c.matrix + size_t(n) * n, small_expected.matrix.begin());
+        }
+        return correct;
+    };
+    const int half = requests / 2;
+    uint64_t batches_before = client.stats().batches;
+    timer.start();
+    for (int r = 0; r < half; r++) {
+        client.submit(*operands[r], r);
+        client.receive();
+    }
+    timer.stop();
+    uint64_t batches_after = client.stats().batches;
+    row(std::format("Small, one at a time{}", check(0, half) ? "" : " BAD"), timer.duration<zen::timer::usec>().count(), half,
+        std::to_string(batches_after - batches_before));
+
+    timer.start();
+    for (int r = half; r < requests; r++) client.submit(*operands[r], r);
+    for (int r = half; r < requests; r++) client.receive();
+    timer.stop();
+    batches_before = batches_after;
+    batches_after = client.stats().batches;
+    row(std::format("Small, pipelined{}", check(half, requests - half) ? "" : " BAD"), timer.duration<zen::timer::usec>().count(),
+        requests - half, std::to_string(batches_after - batches_before));
+
+    timer.start();
+    Mat large_expected(matrix1.rows, matrix2.cols);
+    in_process(matrix1, matrix2, large_expected);
+    timer.stop();
+    row("Large, in-process", timer.duration<zen::timer::usec>().count(), 1, "-");
+    timer.start();
+    client.submit(large, 0);
+    client.receive();
+    timer.stop();
+    bool large_correct = std::equal(large.c().matrix, large.c().matrix + large_expected.matrix.size(), large_expected.matrix.begin());
+    row(std::format("Large, service{}", large_correct ? "" : " BAD"), timer.duration<zen::timer::usec>().count(), 1, "1");
+    zen::print("+--------------------------------+------------+-----------------+------------+\n");
+
+    MatMath::service::StatsReply stats = client.stats();
+    print_latency_histogram("Batched", stats.batched);
+    print_latency_histogram("Direct", stats.direct);
+    client.shutdown();
+    daemon.join();
+#endif
+}
+
+// A fixed weight (B) against a stream of inputs cycling through a few distinct A's, multiplied
+// directly and through result caches of different sizes (one that holds every product, one that
+// holds a single product and thrashes), then the cost of the content hash next to the multiply
+void run_cache_benchmark(MatView matrix1, MatView matrix2, size_t capacity_mb, const ThreadConfig& config) {
+    const int distinct = 4, requests = 16;
+    std::vector<Mat> inputs;
+    for (int v = 0; v < distinct; v++) {
+        Mat input(matrix1.rows, matrix1.cols);
+        std::copy_n(matrix1.matrix, input.matrix.size(), input.matrix.begin());
+        if (!input.matrix.empty()) input.matrix[0] += v;
+        inputs.push_back(std::move(input));
+    }
+    std::vector<Mat> expected;
+    for (const Mat& input : inputs) expected.push_back(MatMath::BlockedMul_threading(input, matrix2, BLOCK_SIZE, config));
+    const size_t result_bytes = size_t(matrix1.rows) * matrix2.cols * sizeof(int);
+
+    zen::print(std::format("\nResult Cache ({} requests over {} distinct inputs, {}x{} * {}x{})\n", requests, distinct,
+                           matrix1.rows, matrix1.cols, matrix2.rows, matrix2.cols));
+    zen::print("+------------------------+------------+--------+--------+-----------+---------+\n");
+    zen::print("| Configuration          | Time (us)  | Hits   | Misses | Evictions | Correct |\n");
+    zen::print("+------------------------+------------+--------+--------+-----------+---------+\n");
+    zen::timer timer;
+    auto row = [&](const std::string& name, MatMath::ResultCache* cache) {
+        bool correct = true;
+        timer.start();
+        for (int r = 0; r < requests; r++) {
+            const Mat& input = inputs[r % distinct];
+            Mat result = cache ? cache->multiply(input, matrix2, ChainKernel::Blocked, config)
+                               : MatMath::BlockedMul_threading(input, matrix2, BLOCK_SIZE, config);
+            correct = correct && result.matrix == expected[r % distinct].matrix;
+        }
+        timer.stop();
+        MatMath::CacheStats stats = cache ? cache->stats() : MatMath::CacheStats{};
+        zen::print(std::format("| {:<22} | {:>10} | {:>6} | {:>6} | {:>9} | {:<7} |\n", name, timer.duration<zen::timer::usec>().count(),
+                               stats.hits, stats.misses, stats.evictions, correct ? "yes" : "BAD"));
+    };
+    row("Uncached", nullptr);
+    MatMath::ResultCache large(capacity_mb << 20);
+    row(std::format("Cache {} MB", capacity_mb), &large);
+    MatMath::ResultCache tiny(result_bytes + result_bytes / 2);
+    row("Cache of one result", &tiny);
+    zen::print("+------------------------+------------+--------+--------+-----------+---------+\n");
+
+    const int hash_runs = 20;
+    auto hash_time = [&](bool simd) {
+        volatile uint64_t sink = 0;   // keeps the hashes from being optimized away
+        timer.start();
+        for (int run = 0; run < hash_runs; run++) sink = sink ^ MatMath::contentHash(matrix1, simd) ^ MatMath::contentHash(matrix2, simd);
+        timer.stop();
+        return double(timer.duration<zen::timer::nsec>().count()) / 1000.0 / hash_runs;
+    };
+    double scalar_us = hash_time(false), simd_us = hash_time(true);
+    timer.start();
+    MatMath::BlockedMul_threading(matrix1, matrix2, BLOCK_SIZE, config);
+    timer.stop();
+    double multiply_us = double(timer.duration<zen::timer::usec>().count());
+    const double operand_bytes = double(size_t(matrix1.rows) * matrix1.cols + size_t(matrix2.rows) * matrix2.cols) * sizeof(int);
+
+    zen::print("\nHash Cost (A and B per request)\n");
+    zen::print("+------------------------+------------+------------+-----------------+\n");
+    zen::print("| Step                   | Time (us)  | GB/s       | Multiply / step |\n");
+    zen::print("+------------------------+------------+------------+-----------------+\n");
+    auto cost_row = [&](const std::string& name, double us) {
+        zen::print(std::format("| {:<22} | {:>10.1f} | {:>10.2f} | {:>14.0f}x |\n", name, us, operand_bytes / (std::max)(us, 0.001) / 1e3,
+                               multiply_us / (std::max)(us, 0.001)));
+    };
+    cost_row("Hash, scalar", scalar_us);
+    cost_row(MatMath::hash::avx2Supported() ? "Hash, AVX2" : "Hash, SIMD (no AVX2)", simd_us);
+    cost_row("Multiply", multiply_us);
+    zen::print("+------------------------+------------+------------+-----------------+\n");
+}
+
 int main(int argc, char* argv[]) {
+    ThreadConfig thread_config = process_thread_args(argc, argv);
+    zen::cmd_args args(argv, argc);
+
+    // Daemon mode replaces the benchmarks entirely
+    auto serve_options = args.get_options("--serve");
+    if (!serve_options.empty()) {
+#ifdef _WIN32
+        zen::log("Error: --serve needs Unix domain sockets, not available on Windows");
+        return 1;
+#else
+        return run_service(serve_options[0], thread_config);
+#endif
+    }
+
     auto [row1, col1, row2, col2] = process_args(argc, argv);
+    int thread_count = resolveThreadCount(thread_config);
+    zen::timer timer;
 
-    int thread_count = 3;
-    Mat matrix1(row1, col1);
-    Mat matrix2(row2, col2);
+    // Operands are either loaded (--load A B: .mat files are mapped, .mtx/.csv parsed) or generated
+    Mat storage1(0, 0), storage2(0, 0);
+    std::unique_ptr<MappedMat> mapped1, mapped2;
+    auto load_options = args.get_options("--load");
+    if (load_options.size() >= 2) {
+        auto load = [&](const std::string& path, Mat& storage, std::unique_ptr<MappedMat>& mapped) {
+            timer.start();
+            std::string how = "zero-copy";
+            if (isTextMatrixFile(path)) {
+                storage = loadTextMatrix(path, thread_config);
+                how = "parsed";
+            } else {
+                mapped = std::make_unique<MappedMat>(path);
+                if (!mapped->isZeroCopy()) { storage = mapped->toMat(); how = "converted"; }
+            }
+            timer.stop();
+            zen::print(std::format("Loaded {} in {} us ({})\n", path, timer.duration<zen::timer::usec>().count(), how));
+        };
+        load(load_options[0], storage1, mapped1);
+        load(load_options[1], storage2, mapped2);
+    } else {
+        storage1 = Mat(row1, col1);
+        storage2 = Mat(row2, col2);
 
-    // Initialize matrices
-    for (int i = 0; i < row1 * col1; i++) {
-        matrix1.matrix[i] = zen::random_int(1, row1 * col1);
+        // Initialize matrices: counter-based, so --seed reproduces them at any thread count
+        auto seed_options = args.get_options("--seed");
+        uint64_t seed = seed_options.empty() ? (uint64_t(std::random_device{}()) << 32 | std::random_device{}())
+                                             : std::stoull(seed_options[0]);
+        timer.start();
+        fillRandom(storage1, seed, 0, 1, row1 * col1, thread_config);
+        fillRandom(storage2, seed, 1, 1, row2 * col2, thread_config);
+        timer.stop();
+        zen::print(std::format("Generated operands in {} us (seed {})\n", timer.duration<zen::timer::usec>().count(), seed));
     }
-    for (int i = 0; i < row2 * col2; i++) {
-        matrix2.matrix[i] = zen::random_int(1, row2 * col2);
+    MatView matrix1 = mapped1 && mapped1->isZeroCopy() ? mapped1->view() : MatView(storage1);
+    MatView matrix2 = mapped2 && mapped2->isZeroCopy() ? mapped2->view() : MatView(storage2);
+    row1 = matrix1.rows; col1 = matrix1.cols;
+    row2 = matrix2.rows; col2 = matrix2.cols;
+    if (matrix1.cols != matrix2.rows) {
+        zen::log(std::format("Error: cannot multiply {}x{} by {}x{}", row1, col1, row2, col2));
+        return 1;
     }
 
-    zen::timer timer;
-    long long recursive_time, naive_time, blocked_time,blocked_thread_time;
+    auto save_options = args.get_options("--save");
+    if (save_options.size() >= 2) {
+        auto save = [](const std::string& path, MatView mat) {
+            if (isTextMatrixFile(path)) writeCsv(path, mat);
+            else writeMatFile(path, mat);
+        };
+        save(save_options[0], matrix1);
+        save(save_options[1], matrix2);
+    }
+
+    long long recursive_time, naive_time, blocked_time,blocked_thread_time, taskgraph_time;
 
     // Recursive matMul
     timer.start();
@@ -71,10 +1239,16 @@ int main(int argc, char* argv[]) {
 
     // BlockedMul with threads
     timer.start();
-    MatMath::BlockedMul_threading(matrix1, matrix2,BLOCK_SIZE);
+    MatMath::BlockedMul_threading(matrix1, matrix2, BLOCK_SIZE, thread_config);
     timer.stop();
     blocked_thread_time = timer.duration<zen::timer::usec>().count();
 
+    // BlockedMul as a tile task graph
+    timer.start();
+    MatMath::BlockedMul_taskgraph(matrix1, matrix2, BLOCK_SIZE, thread_config);
+    timer.stop();
+    taskgraph_time = timer.duration<zen::timer::usec>().count();
+
     // Table header for timings
     zen::print(std::format("\nMatrix Multiplication Performance ({}x{} * {}x{})\n", row1, col1, row2, col2));
     zen::print("+----------------------+------------+\n");
@@ -85,7 +1259,8 @@ int main(int argc, char* argv[]) {
     zen::print(std::format("| {:<20} | {:>10} |\n", "Recursive (matMul)", recursive_time));
     zen::print(std::format("| {:<20} | {:>10} |\n", "Naive (multiply)", naive_time));
     zen::print(std::format("| {:<20} | {:>10} |\n", "Blocked (BlockedMul)", blocked_time));
-    zen::print(std::format("| {:<20} | {:>10} |\n", "Blocked (ThreadMul)", blocked_thread_time));
+    zen::print(std::format("| {:<20} | {:>10} |\n", std::format("Blocked ({} thr)", thread_count), blocked_thread_time));
+    zen::print(std::format("| {:<20} | {:>10} |\n", "Blocked (TaskGraph)", taskgraph_time));
 
     zen::print("+----------------------+------------+\n");
 
@@ -100,14 +1275,95 @@ int main(int argc, char* argv[]) {
     double blocked_vs_naive = static_cast<double>(blocked_time) / naive_time;
     double rec_vs_blocked = static_cast<double>(recursive_time) / blocked_time;
     double thread_blocked = static_cast<double>(blocked_thread_time) / blocked_time;
+    double graph_vs_thread = static_cast<double>(taskgraph_time) / blocked_thread_time;
 
     // Table rows for factors
     zen::print(std::format("| {:<30} | {:>10.2f} |\n", "Recursive vs. Naive", rec_vs_naive));
     zen::print(std::format("| {:<30} | {:>10.2f} |\n", "Blocked vs. Naive", blocked_vs_naive));
     zen::print(std::format("| {:<30} | {:>10.2f} |\n", "Recursive vs. Blocked", rec_vs_blocked));
     zen::print(std::format("| {:<30} | {:>10.2f} |\n", "Threading vs. no threading", thread_blocked));
+    zen::print(std::format("| {:<30} | {:>10.2f} |\n", "Task graph vs. tile threads", graph_vs_thread));
 
     zen::print("+--------------------------------+------------+\n");
 
+    if (args.is_present("--scaling")) {
+        run_scaling_benchmark(matrix1, matrix2, thread_config);
+    }
+    if (args.is_present("--decomposition")) {
+        run_decomposition_benchmark(matrix1, matrix2, thread_config);
+    }
+    if (args.is_present("--semiring")) {
+        run_semiring_benchmark(matrix1, matrix2);
+    }
+    if (args.is_present("--modp")) {
+        run_modp_benchmark(matrix1, matrix2);
+    }
+    if (args.is_present("--bitmat")) {
+        run_bitmat_benchmark(matrix1, matrix2, thread_config);
+    }
+    if (args.is_present("--int8")) {
+        run_int8_benchmark(matrix1, matrix2, thread_config);
+    }
+    if (args.is_present("--sparse")) {
+        run_sparse_benchmark(matrix1, matrix2, thread_config);
+    }
+    if (args.is_present("--blocksparse")) {
+        run_blocksparse_benchmark(matrix1, matrix2, thread_config);
+    }
+    if (args.is_present("--syrk")) {
+        run_syrk_benchmark(matrix1, thread_config);
+    }
+    if (args.is_present("--structured")) {
+        auto structured_options = args.get_options("--structured");
+        int bandwidth = structured_options.empty() ? 8 : std::stoi(structured_options[0]);
+        run_structured_benchmark(matrix1, matrix2, bandwidth, thread_config);
+    }
+    if (args.is_present("--transpose")) {
+        run_transpose_benchmark(matrix1, matrix2, thread_config);
+    }
+    if (args.is_present("--epilogue")) {
+        run_epilogue_benchmark(matrix1, matrix2, thread_config);
+    }
+    if (args.is_present("--expr")) {
+        run_expr_benchmark(matrix1, matrix2, thread_config);
+    }
+    if (args.is_present("--chain")) {
+        run_chain_benchmark(matrix1, matrix2, thread_config);
+    }
+    if (args.is_present("--matpow")) {
+        auto matpow_options = args.get_options("--matpow");
+        unsigned long long power = matpow_options.empty() ? 100 : std::stoull(matpow_options[0]);
+        run_matpow_benchmark(matrix1, power, thread_config);
+    }
+    if (args.is_present("--inplace")) {
+        auto inplace_options = args.get_options("--inplace");
+        int iterations = inplace_options.empty() ? 100 : std::stoi(inplace_options[0]);
+        run_inplace_benchmark(matrix1, matrix2, iterations, thread_config);
+    }
+    if (args.is_present("--async")) {
+        auto async_options = args.get_options("--async");
+        int small_jobs = async_options.empty() ? 32 : std::stoi(async_options[0]);
+        run_async_benchmark(matrix1, matrix2, small_jobs, thread_config);
+    }
+    if (args.is_present("--service")) {
+        auto service_options = args.get_options("--service");
+        int requests = service_options.empty() ? 256 : std::stoi(service_options[0]);
+        run_service_benchmark(matrix1, matrix2, requests, thread_config);
+    }
+    if (args.is_present("--cache")) {
+        auto cache_options = args.get_options("--cache");
+        size_t capacity_mb = cache_options.empty() ? 256 : std::stoul(cache_options[0]);
+        run_cache_benchmark(matrix1, matrix2, capacity_mb, thread_config);
+    }
+    auto ooc_options = args.get_options("--ooc");
+    if (!ooc_options.empty()) {
+        size_t budget_mb = ooc_options.size() > 1 ? std::stoul(ooc_options[1]) : 64;
+        run_ooc_benchmark(matrix1, matrix2, ooc_options[0], budget_mb);
+    }
+    auto summa_options = args.get_options("--summa");
+    if (!summa_options.empty()) {
+        run_summa_benchmark(matrix1, matrix2, std::stoi(summa_options[0]));
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Memory-mapped file. Read-only mappings open an existing file; writable mappings
+// create (or resize) the file to the requested size first.
+class MappedFile {
+public:
+    enum class Advice { Sequential, WillNeed, DontNeed };
+
+    MappedFile() = default;
+
+    MappedFile(const std::string& path, bool writable, size_t size = 0) : writable_(writable) {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) throw std::runtime_error("cannot open " + path);
+        if (writable) {
+            LARGE_INTEGER length;
+            length.QuadPart = static_cast<LONGLONG>(size);
+            SetFilePointerEx(file_, length, nullptr, FILE_BEGIN);
+            SetEndOfFile(file_);
+            size_ = size;
+        } else {
+            LARGE_INTEGER length;
+            GetFileSizeEx(file_, &length);
+            size_ = static_cast<size_t>(length.QuadPart);
+        }
+        if (size_ == 0) return;
+        mapping_ = CreateFileMappingA(file_, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) { close(); throw std::runtime_error("cannot map " + path); }
+        data_ = static_cast<char*>(MapViewOfFile(mapping_, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+        if (!data_) { close(); throw std::runtime_error("cannot map " + path); }
+#else
+        fd_ = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+        if (fd_ < 0) throw std::runtime_error("cannot open " + path);
+        if (writable) {
+            if (ftruncate(fd_, static_cast<off_t>(size)) != 0) { close(); throw std::runtime_error("cannot resize " + path); }
+            size_ = size;
+        } else {
+            struct stat st;
+            if (fstat(fd_, &st) != 0) { close(); throw std::runtime_error("cannot stat " + path); }
+            size_ = static_cast<size_t>(st.st_size);
+        }
+        if (size_ == 0) return;
+        void* base = mmap(nullptr, size_, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd_, 0);
+        if (base == MAP_FAILED) { close(); throw std::runtime_error("cannot map " + path); }
+        data_ = static_cast<char*>(base);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            data_ = other.data_; size_ = other.size_; writable_ = other.writable_;
+#ifdef _WIN32
+            file_ = other.file_; mapping_ = other.mapping_;
+            other.file_ = INVALID_HANDLE_VALUE; other.mapping_ = nullptr;
+#else
+            fd_ = other.fd_;
+            other.fd_ = -1;
+#endif
+            other.data_ = nullptr; other.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~MappedFile() { close(); }
+
+    char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool writable() const { return writable_; }
+
+    // Paging hint for [offset, offset + length). No-op where unsupported. Sequential and WillNeed
+    // are rounded out to whole pages; DontNeed is rounded in, so a page shared with neighbouring
+    // data (e.g. the next tile's rows) is kept. DontNeed unmaps the pages from this process and then
+    // asks the kernel to drop them from the page cache too; clean pages go at once, dirty ones only
+    // after they have been written back.
+    void advise(size_t offset, size_t length, Advice advice) const {
+#ifndef _WIN32
+        if (!data_ || offset >= size_) return;
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t begin = offset / page * page;
+        size_t end = (std::min)(offset + length, size_);
+        if (advice == Advice::DontNeed) {
+            begin = (offset + page - 1) / page * page;
+            if (end < size_) end = end / page * page;  // the tail page past size_ holds nothing else
+            if (begin >= end) return;
+        }
+        int flag = advice == Advice::Sequential ? MADV_SEQUENTIAL
+                 : advice == Advice::WillNeed   ? MADV_WILLNEED
+                                                : MADV_DONTNEED;
+        madvise(data_ + begin, end - begin, flag);
+        if (advice == Advice::DontNeed) {
+            posix_fadvise(fd_, static_cast<off_t>(begin), static_cast<off_t>(end - begin), POSIX_FADV_DONTNEED);
+        }
+#else
+        (void)offset; (void)length; (void)advice;
+#endif
+    }
+
+    // Schedule write-back of dirty pages in [offset, offset + length) without waiting for it
+    void flush(size_t offset, size_t length) const {
+        if (!data_ || !writable_ || offset >= size_) return;
+#ifdef _WIN32
+        FlushViewOfFile(data_ + offset, (std::min)(length, size_ - offset));
+#else
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t begin = offset / page * page;
+        size_t end = (std::min)(offset + length, size_);
+        msync(data_ + begin, end - begin, MS_ASYNC);
+#endif
+    }
+
+private:
+    void close() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) munmap(data_, size_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    bool writable_ = false;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
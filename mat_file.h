@@ -0,0 +1,160 @@
+#pragma once
+
+// Binary matrix file (.mat):
+//   64-byte header (little-endian), then the payload starting at payload_offset (a multiple of 64).
+//   Row-major: element (i, j) is at payload[i * stride + j]; column-major: payload[j * stride + i].
+// Int32 row-major files with stride == cols load as a MatView straight over the mapping.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include "Rec_MatMul.h"
+#include "mapped_file.h"
+#include "ooc_matmul.h"
+
+enum class MatDType : uint32_t { Int32 = 1, Int8 = 2, UInt8 = 3, Float32 = 4, Float64 = 5 };
+enum class MatLayout : uint32_t { RowMajor = 0, ColMajor = 1 };
+
+struct MatFileHeader {
+    char magic[8];            // "MATBIN1\0"
+    uint32_t dtype;           // MatDType
+    uint32_t layout;          // MatLayout
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t stride;          // elements between consecutive rows (row-major) or columns (col-major)
+    uint64_t payload_offset;  // bytes from file start, multiple of 64
+    uint8_t reserved[16];
+};
+static_assert(sizeof(MatFileHeader) == 64, "MatFileHeader must be exactly 64 bytes");
+
+const char MAT_FILE_MAGIC[8] = {'M', 'A', 'T', 'B', 'I', 'N', '1', '\0'};
+
+size_t matDTypeSize(MatDType dtype) {
+    switch (dtype) {
+        case MatDType::Int32:   return 4;
+        case MatDType::Int8:    return 1;
+        case MatDType::UInt8:   return 1;
+        case MatDType::Float32: return 4;
+        case MatDType::Float64: return 8;
+    }
+    throw std::runtime_error("unknown matrix dtype " + std::to_string(static_cast<uint32_t>(dtype)));
+}
+
+// Write an int32 row-major matrix. Rows are padded out to `stride` elements (0 = cols).
+void writeMatFile(const std::string& path, MatView mat, int stride = 0) {
+    if (stride == 0) stride = mat.cols;
+    if (stride < mat.cols) throw std::invalid_argument("stride must be at least cols");
+
+    MatFileHeader header{};
+    std::memcpy(header.magic, MAT_FILE_MAGIC, sizeof(header.magic));
+    header.dtype = static_cast<uint32_t>(MatDType::Int32);
+    header.layout = static_cast<uint32_t>(MatLayout::RowMajor);
+    header.rows = mat.rows;
+    header.cols = mat.cols;
+    header.stride = stride;
+    header.payload_offset = 64;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) throw std::runtime_error("cannot create " + path);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (stride == mat.cols) {
+        file.write(reinterpret_cast<const char*>(mat.matrix), std::streamsize(size_t(mat.rows) * mat.cols * sizeof(int)));
+    } else {
+        std::vector<int> padding(stride - mat.cols, 0);
+        for (int i = 0; i < mat.rows; i++) {
+            file.write(reinterpret_cast<const char*>(mat.matrix + size_t(i) * mat.cols), std::streamsize(mat.cols * sizeof(int)));
+            file.write(reinterpret_cast<const char*>(padding.data()), std::streamsize(padding.size() * sizeof(int)));
+        }
+    }
+    if (!file) throw std::runtime_error("failed writing " + path);
+}
+
+// A .mat file mapped read-only. The mapping lives as long as this object; views taken from it must not outlive it.
+class MappedMat {
+public:
+    explicit MappedMat(const std::string& path) : path_(path), file_(path, false) {
+        if (file_.size() < sizeof(MatFileHeader)) throw std::runtime_error(path + " is not a matrix file");
+        std::memcpy(&header_, file_.data(), sizeof(header_));
+        if (std::memcmp(header_.magic, MAT_FILE_MAGIC, sizeof(header_.magic)) != 0) {
+            throw std::runtime_error(path + " is not a matrix file");
+        }
+        if (header_.layout != static_cast<uint32_t>(MatLayout::RowMajor) &&
+            header_.layout != static_cast<uint32_t>(MatLayout::ColMajor)) {
+            throw std::runtime_error(path + " has an unknown layout " + std::to_string(header_.layout));
+        }
+        size_t element = matDTypeSize(dtype());
+        uint64_t lines = layout() == MatLayout::RowMajor ? header_.rows : header_.cols;
+        uint64_t line_length = layout() == MatLayout::RowMajor ? header_.cols : header_.rows;
+        if (header_.payload_offset < sizeof(MatFileHeader) || header_.payload_offset % 64 != 0 ||
+            header_.stride < line_length || header_.rows > INT32_MAX || header_.cols > INT32_MAX) {
+            throw std::runtime_error(path + " has an invalid header");
+        }
+        // Payload extent in bytes; a header whose extent does not fit in 64 bits cannot match any file
+        auto mulFits = [](uint64_t a, uint64_t b) { return a == 0 || b <= UINT64_MAX / a; };
+        uint64_t payload = 0;
+        if (lines > 0) {
+            if (!mulFits(lines - 1, header_.stride)) throw std::runtime_error(path + " is truncated");
+            uint64_t elements = (lines - 1) * header_.stride;
+            if (elements > UINT64_MAX - line_length || !mulFits(elements + line_length, element)) {
+                throw std::runtime_error(path + " is truncated");
+            }
+            payload = (elements + line_length) * element;
+        }
+        if (payload > file_.size() || header_.payload_offset > file_.size() - payload) {
+            throw std::runtime_error(path + " is truncated");
+        }
+        file_.advise(header_.payload_offset, payload, MappedFile::Advice::Sequential);
+    }
+
+    int rows() const { return static_cast<int>(header_.rows); }
+    int cols() const { return static_cast<int>(header_.cols); }
+    MatDType dtype() const { return static_cast<MatDType>(header_.dtype); }
+    MatLayout layout() const { return static_cast<MatLayout>(header_.layout); }
+    const MatFileHeader& header() const { return header_; }
+    const char* payload() const { return file_.data() + header_.payload_offset; }
+
+    // True when the payload can be used in place as a MatView
+    bool isZeroCopy() const {
+        return dtype() == MatDType::Int32 && layout() == MatLayout::RowMajor && header_.stride == header_.cols;
+    }
+
+    MatView view() const {
+        if (!isZeroCopy()) {
+            throw std::runtime_error(path_ + " needs conversion (dtype, layout or stride); use toMat()");
+        }
+        return MatView(rows(), cols(), reinterpret_cast<const int*>(payload()));
+    }
+
+    // Copying load for any int32 file, or integer dtypes widened to int
+    Mat toMat() const {
+        Mat mat(rows(), cols());
+        bool row_major = layout() == MatLayout::RowMajor;
+        for (int i = 0; i < rows(); i++) {
+            for (int j = 0; j < cols(); j++) {
+                size_t index = row_major ? size_t(i) * header_.stride + j : size_t(j) * header_.stride + i;
+                int value;
+                switch (dtype()) {
+                    case MatDType::Int32: std::memcpy(&value, payload() + index * 4, 4); break;
+                    case MatDType::Int8:  value = static_cast<int8_t>(payload()[index]); break;
+                    case MatDType::UInt8: value = static_cast<uint8_t>(payload()[index]); break;
+                    default: throw std::runtime_error(path_ + " has a floating-point dtype, Mat holds int");
+                }
+                mat.matrix[size_t(i) * mat.cols + j] = value;
+            }
+        }
+        return mat;
+    }
+
+    // Open the same file for the out-of-core multiply (int32, row-major, stride == cols only)
+    FileMat toFileMat() const {
+        if (!isZeroCopy()) throw std::runtime_error(path_ + " must be int32 row-major with stride == cols");
+        return FileMat::open(path_, rows(), cols(), header_.payload_offset);
+    }
+
+private:
+    std::string path_;
+    MappedFile file_;
+    MatFileHeader header_{};
+};
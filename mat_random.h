@@ -0,0 +1,75 @@
+#pragma once
+
+// Counter-based random matrix fill (Philox4x32-10).
+// Element n of a matrix is a pure function of (seed, stream, n), so the contents are identical
+// for any thread count or chunking. Counters are processed in batches of 8 laid out
+// lane by lane, which compilers turn into SIMD 32x32->64 multiplies.
+
+#include <cstdint>
+#include "Rec_MatMul.h"
+
+namespace philox {
+
+    const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+    const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+    const int ROUNDS = 10;
+    const int BATCH = 8;
+
+    // 4 x 32-bit outputs for each of BATCH consecutive counters starting at `counter`
+    void generateBatch(uint64_t counter, uint32_t key0, uint32_t key1, uint32_t out[4][BATCH]) {
+        uint32_t x0[BATCH], x1[BATCH], x2[BATCH], x3[BATCH];
+        for (int l = 0; l < BATCH; l++) {
+            uint64_t c = counter + l;
+            x0[l] = static_cast<uint32_t>(c);
+            x1[l] = static_cast<uint32_t>(c >> 32);
+            x2[l] = 0;
+            x3[l] = 0;
+        }
+        uint32_t k0 = key0, k1 = key1;
+        for (int round = 0; round < ROUNDS; round++) {
+            for (int l = 0; l < BATCH; l++) {
+                uint64_t p0 = uint64_t(M0) * x0[l];
+                uint64_t p1 = uint64_t(M1) * x2[l];
+                uint32_t y0 = static_cast<uint32_t>(p1 >> 32) ^ x1[l] ^ k0;
+                uint32_t y1 = static_cast<uint32_t>(p1);
+                uint32_t y2 = static_cast<uint32_t>(p0 >> 32) ^ x3[l] ^ k1;
+                uint32_t y3 = static_cast<uint32_t>(p0);
+                x0[l] = y0; x1[l] = y1; x2[l] = y2; x3[l] = y3;
+            }
+            k0 += W0;
+            k1 += W1;
+        }
+        for (int l = 0; l < BATCH; l++) {
+            out[0][l] = x0[l]; out[1][l] = x1[l]; out[2][l] = x2[l]; out[3][l] = x3[l];
+        }
+    }
+}
+
+// Fill `mat` with values uniform in [min, max). Different streams give independent matrices
+// from the same seed.
+void fillRandom(Mat& mat, uint64_t seed, uint32_t stream, int min, int max, const ThreadConfig& config = {}) {
+    const uint32_t key0 = static_cast<uint32_t>(seed);
+    const uint32_t key1 = static_cast<uint32_t>(seed >> 32) ^ (stream * 0x85EBCA6Bu);
+    const uint64_t range = max > min ? uint64_t(int64_t(max) - min) : 1;
+    const size_t total = mat.matrix.size();
+    const size_t per_batch = 4 * philox::BATCH;
+    const size_t batches = (total + per_batch - 1) / per_batch;
+    int* data = mat.matrix.data();
+
+    int thread_count = resolveThreadCount(config);
+    MatMath::runWorkers(config, [&](int t) {
+        size_t first = batches * t / thread_count;
+        size_t last = batches * (t + 1) / thread_count;
+        uint32_t out[4][philox::BATCH];
+        for (size_t b = first; b < last; b++) {
+            philox::generateBatch(b * philox::BATCH, key0, key1, out);
+            size_t base = b * per_batch;
+            size_t count = (std::min)(per_batch, total - base);
+            for (size_t n = 0; n < count; n++) {
+                // Multiply-shift maps 32 random bits onto the range without a division
+                uint32_t bits = out[n % 4][n / 4];
+                data[base + n] = static_cast<int>(min + static_cast<int64_t>((bits * range) >> 32));
+            }
+        }
+    });
+}
@@ -0,0 +1,552 @@
+#pragma once
+
+// Long-lived local multiply service over a Unix domain socket.
+// A client puts A (m x k), B (k x n) and room for C (m x n) back to back, row-major int32, in one
+// shared memory segment and sends its descriptor with the request (SCM_RIGHTS over a
+// SOCK_SEQPACKET socket). The daemon maps the segment and writes C straight into it, so operands
+// and the result are never copied through the socket; the reply only says the result is there.
+// The daemon keeps a warm MulPool and per-worker accumulator buffers for its whole lifetime.
+// Small requests (at most small_macs multiply-adds) of the same shape are coalesced while more
+// input is already waiting on the sockets: a batch is dispatched as soon as the daemon finds no
+// further message, reaches batch_max requests or has held its oldest request for window_us, so
+// an idle daemon adds no delay. Each batch runs as one pool job whose tiles span all of its
+// requests, so many tiny products share one dispatch and spread over the workers.
+// Every request's latency (receipt to reply) goes into a log2 histogram, kept separately for
+// batched and direct requests and available to clients through a Stats request.
+// Client sockets are non-blocking on the daemon side: a reply that does not fit is queued on its
+// connection and sent when poll() reports room, so a client that stops reading never stalls the
+// workers or the other clients; one that lets MAX_QUEUED replies pile up is disconnected.
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "Rec_MatMul.h"
+#include "epilogue.h"
+#include "async_matmul.h"
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+// Log2 buckets of microseconds: bucket b holds latencies in [2^b, 2^(b+1)) us, bucket 0 also < 1 us
+struct LatencyHistogram {
+    static const int BUCKETS = 32;
+    std::array<std::atomic<unsigned long long>, BUCKETS> counts{};
+
+    void record(long long us) {
+        int bucket = 0;
+        while (bucket + 1 < BUCKETS && (1LL << (bucket + 1)) <= us) bucket++;
+        counts[bucket]++;
+    }
+
+    unsigned long long total() const {
+        unsigned long long sum = 0;
+        for (const auto& count : counts) sum += count;
+        return sum;
+    }
+};
+
+#ifndef _WIN32
+
+namespace MatMath {
+
+    namespace service {
+
+        enum class Op : uint32_t { Multiply = 1, Stats = 2, Shutdown = 3 };
+
+        // A Multiply request carries the operand segment's descriptor
+        struct Request {
+            uint32_t op;
+            uint32_t reserved;
+            uint64_t id;
+            int32_t m, k, n;
+            int32_t reserved2;
+        };
+
+        struct Reply {
+            uint64_t id;
+            int32_t status;         // 0, or -1 for a malformed or oversized request
+            int32_t batch;          // requests in the batch that computed it
+            int64_t latency_us;     // receipt to reply, as seen by the daemon
+        };
+
+        struct StatsReply {
+            uint64_t requests, batches, batched_requests;
+            uint64_t batched[LatencyHistogram::BUCKETS];
+            uint64_t direct[LatencyHistogram::BUCKETS];
+        };
+
+        // Bytes of the A | B | C segment for an m x k by k x n product (dimensions >= 0);
+        // false if the count does not fit in a size_t
+        bool segmentBytes(int m, int k, int n, size_t& bytes) {
+            size_t a, b, c;
+            return !__builtin_mul_overflow(size_t(m), size_t(k), &a) && !__builtin_mul_overflow(size_t(k), size_t(n), &b) &&
+                   !__builtin_mul_overflow(size_t(m), size_t(n), &c) && !__builtin_add_overflow(a, b, &bytes) &&
+                   !__builtin_add_overflow(bytes, c, &bytes) && !__builtin_mul_overflow(bytes, sizeof(int), &bytes);
+        }
+
+        // Multiply-adds of the product (dimensions >= 0); false if they do not fit in a long long
+        bool macCount(int m, int k, int n, long long& macs) {
+            return !__builtin_mul_overflow(static_cast<long long>(m), static_cast<long long>(k), &macs) &&
+                   !__builtin_mul_overflow(macs, static_cast<long long>(n), &macs);
+        }
+
+        // Shared memory segment unlinked right after creation; only its descriptor names it
+        int createSegment(size_t bytes) {
+            static std::atomic<int> counter{0};
+            std::string name = "/matmul_service_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+            int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd < 0) throw std::runtime_error("shm_open failed for " + name);
+            shm_unlink(name.c_str());
+            if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+                close(fd);
+                throw std::runtime_error("ftruncate failed on shared memory segment");
+            }
+            return fd;
+        }
+
+        // One message, with an optional descriptor attached
+        bool sendMessage(int socket, const void* data, size_t bytes, int fd = -1) {
+            iovec iov{const_cast<void*>(data), bytes};
+            msghdr msg{};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+            if (fd >= 0) {
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+                cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_RIGHTS;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+                std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+            }
+            return sendmsg(socket, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(bytes);
+        }
+
+        // Bytes received (0 when the peer closed), and the attached descriptor or -1
+        ssize_t receiveMessage(int socket, void* data, size_t bytes, int& fd) {
+            iovec iov{data, bytes};
+            msghdr msg{};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            ssize_t received = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+            fd = -1;
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); received > 0 && cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+            }
+            return received;
+        }
+
+        sockaddr_un socketAddress(const std::string& path) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(addr.sun_path)) throw std::invalid_argument("socket path too long: " + path);
+            std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            return addr;
+        }
+
+        // A connected client; the socket closes when the last pending request releases it
+        struct Connection {
+            static const size_t MAX_QUEUED = 4096;
+
+            int fd;
+            std::atomic<bool> dropped{false};
+            explicit Connection(int f) : fd(f) {}
+            ~Connection() { close(fd); }
+
+            // Sends at once when nothing is queued ahead and the socket has room, otherwise queues.
+            // Called from the pool's workers and the poll thread alike.
+            void send(const void* data, size_t bytes) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (dropped) return;
+                if (outbox_.empty()) {
+                    if (sendMessage(fd, data, bytes)) return;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) return drop();
+                }
+                if (outbox_.size() >= MAX_QUEUED) return drop();
+                const char* message = static_cast<const char*>(data);
+                outbox_.emplace_back(message, message + bytes);
+            }
+
+            // Sends queued replies while the socket has room; false once the connection is dead
+            bool flush() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                while (!dropped && !outbox_.empty()) {
+                    if (!sendMessage(fd, outbox_.front().data(), outbox_.front().size())) {
+                        if (errno != EAGAIN && errno != EWOULDBLOCK) drop();
+                        break;
+                    }
+                    outbox_.pop_front();
+                }
+                return !dropped;
+            }
+
+            bool queued() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return !outbox_.empty();
+            }
+
+        private:
+            // Called with the lock held; the poll loop sees the hang-up and forgets the client
+            void drop() {
+                dropped = true;
+                outbox_.clear();
+                shutdown(fd, SHUT_RDWR);
+            }
+
+            std::mutex mutex_;
+            std::deque<std::vector<char>> outbox_;
+        };
+
+        // A received Multiply with its operand segment mapped
+        struct Pending {
+            std::shared_ptr<Connection> connection;
+            Request request;
+            void* base = MAP_FAILED;
+            size_t bytes = 0;
+            std::chrono::steady_clock::time_point received;
+
+            ~Pending() { if (base != MAP_FAILED) munmap(base, bytes); }
+
+            MatView a() const { return MatView(request.m, request.k, static_cast<const int*>(base)); }
+            MatView b() const { return MatView(request.k, request.n, static_cast<const int*>(base) + size_t(request.m) * request.k); }
+            OutView<int> c() const {
+                int* data = static_cast<int*>(base) + size_t(request.m) * request.k + size_t(request.k) * request.n;
+                return OutView<int>(request.m, request.n, data);
+            }
+        };
+    }
+
+    struct ServiceConfig {
+        std::string socket_path;
+        ThreadConfig threads = {};
+        int batch_max = 64;                         // requests per batch
+        long long small_macs = 128LL * 128 * 128;   // larger requests run on their own
+        int window_us = 200;                        // longest a small request waits under steady input
+        size_t max_segment_bytes = size_t(4) << 30; // larger requests are rejected
+    };
+
+    class MatMulService {
+    public:
+        explicit MatMulService(const ServiceConfig& config) : config_(config), pool_(config.threads) {
+            sockaddr_un addr = service::socketAddress(config.socket_path);
+            listen_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+            if (listen_fd_ < 0) throw std::runtime_error("cannot create socket");
+            unlink(config.socket_path.c_str());
+            if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd_, 64) != 0) {
+                close(listen_fd_);
+                throw std::runtime_error("cannot listen on " + config.socket_path);
+            }
+        }
+
+        ~MatMulService() {
+            close(listen_fd_);
+            unlink(config_.socket_path.c_str());
+        }
+
+        MatMulService(const MatMulService&) = delete;
+        MatMulService& operator=(const MatMulService&) = delete;
+
+        // Safe from a signal handler or another thread; run() returns within about 100 ms
+        void stop() { stopping_ = true; }
+
+        const LatencyHistogram& batchedLatency() const { return batched_latency_; }
+        const LatencyHistogram& directLatency() const { return direct_latency_; }
+        unsigned long long requests() const { return requests_; }
+        unsigned long long batches() const { return batches_; }
+
+        // Serve until stop() or a Shutdown request, then finish every accepted request
+        void run() {
+            std::vector<std::shared_ptr<service::Connection>> connections;
+            while (!stopping_) {
+                std::vector<pollfd> fds{{listen_fd_, POLLIN, 0}};
+                for (const auto& connection : connections) {
+                    fds.push_back({connection->fd, static_cast<short>(POLLIN | (connection->queued() ? POLLOUT : 0)), 0});
+                }
+                // With requests waiting, only look for input already there
+                int ready = poll(fds.data(), fds.size(), waiting_.empty() ? 100 : 0);
+                if (ready < 0 && errno != EINTR) break;
+
+                std::vector<std::shared_ptr<service::Connection>> open;
+                for (size_t c = 0; c < connections.size(); c++) {
+                    short events = fds[c + 1].revents;
+                    if ((events & POLLOUT) && !connections[c]->flush()) continue;
+                    if (events & POLLIN) {
+                        if (receive(connections[c]) && !connections[c]->dropped) open.push_back(connections[c]);
+                    } else if (!(events & (POLLHUP | POLLERR)) && !connections[c]->dropped) {
+                        open.push_back(connections[c]);
+                    }
+                }
+                // A new client is polled from the next round on
+                if (fds[0].revents & POLLIN) {
+                    int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+                    if (fd >= 0) open.push_back(std::make_shared<service::Connection>(fd));
+                }
+                connections.swap(open);
+                flushBatches(ready <= 0);
+            }
+            flushBatches(true);
+            while (in_flight_ > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            for (const auto& connection : connections) connection->flush();
+        }
+
+    private:
+        using Shape = std::tuple<int, int, int>;
+        using Batch = std::vector<std::shared_ptr<service::Pending>>;
+
+        // Handles one message; false once the client has gone
+        bool receive(const std::shared_ptr<service::Connection>& connection) {
+            service::Request request{};
+            int fd = -1;
+            ssize_t received = service::receiveMessage(connection->fd, &request, sizeof(request), fd);
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+            if (received <= 0) return false;
+            if (request.op == uint32_t(service::Op::Shutdown)) {
+                stopping_ = true;
+            } else if (request.op == uint32_t(service::Op::Stats)) {
+                service::StatsReply stats{requests_, batches_, batched_requests_, {}, {}};
+                for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+                    stats.batched[b] = batched_latency_.counts[b];
+                    stats.direct[b] = direct_latency_.counts[b];
+                }
+                connection->send(&stats, sizeof(stats));
+            } else if (request.op == uint32_t(service::Op::Multiply)) {
+                admit(connection, request, fd);
+            }
+            if (fd >= 0 && request.op != uint32_t(service::Op::Multiply)) close(fd);
+            return true;
+        }
+
+        void admit(const std::shared_ptr<service::Connection>& connection, const service::Request& request, int fd) {
+            auto pending = std::make_shared<service::Pending>();
+            pending->connection = connection;
+            pending->request = request;
+            pending->received = std::chrono::steady_clock::now();
+            struct stat st;
+            long long macs = 0;
+            bool valid = fd >= 0 && request.m >= 0 && request.k >= 0 && request.n >= 0 &&
+                         service::segmentBytes(request.m, request.k, request.n, pending->bytes) &&
+                         pending->bytes <= config_.max_segment_bytes &&
+                         service::macCount(request.m, request.k, request.n, macs) && fstat(fd, &st) == 0;
+            if (valid) {
+                valid = size_t(st.st_size) >= pending->bytes;
+                if (valid && pending->bytes) {
+                    pending->base = mmap(nullptr, pending->bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                    valid = pending->base != MAP_FAILED;
+                }
+            }
+            if (fd >= 0) close(fd);
+            if (!valid) {
+                service::Reply reply{request.id, -1, 0, 0};
+                connection->send(&reply, sizeof(reply));
+                return;
+            }
+            requests_++;
+            if (macs > config_.small_macs) {
+                dispatch({pending});
+                return;
+            }
+            Batch& batch = waiting_[Shape{request.m, request.k, request.n}];
+            batch.push_back(pending);
+            if (static_cast<int>(batch.size()) >= config_.batch_max) {
+                Batch full;
+                full.swap(batch);
+                waiting_.erase(Shape{request.m, request.k, request.n});
+                dispatch(std::move(full));
+            }
+        }
+
+        // Dispatch every batch whose oldest request has waited out the window (or all of them)
+        void flushBatches(bool all) {
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = waiting_.begin(); it != waiting_.end();) {
+                long long waited = std::chrono::duration_cast<std::chrono::microseconds>(now - it->second.front()->received).count();
+                if (all || waited >= config_.window_us) {
+                    dispatch(std::move(it->second));
+                    it = waiting_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        // One pool job over the tiles of every request in the batch, each tile computed in the
+        // pool's kernel blocks; replies go out from the worker that finishes it
+        void dispatch(Batch batch) {
+            const int tile = pool_.tile(), block = pool_.block();
+            auto shared = std::make_shared<Batch>(std::move(batch));
+            std::vector<int> first_tile{0};
+            for (const auto& pending : *shared) {
+                const service::Request& r = pending->request;
+                first_tile.push_back(first_tile.back() + ((r.m + tile - 1) / tile) * ((r.n + tile - 1) / tile));
+            }
+            auto job = std::make_shared<MulJob>(0, 0);
+            job->tiles = first_tile.back();
+            job->tile_macs = static_cast<long long>(tile) * tile * (std::max)(shared->front()->request.k, 1);
+            job->run_tile = [shared, first_tile, tile, block](MulJob&, int t) {
+                size_t idx = std::upper_bound(first_tile.begin(), first_tile.end(), t) - first_tile.begin() - 1;
+                const service::Pending& pending = *(*shared)[idx];
+                const int local = t - first_tile[idx];
+                const int row_tiles = (pending.request.m + tile - 1) / tile;
+                const int i0 = (local % row_tiles) * tile, j0 = (local / row_tiles) * tile;
+                const int i1 = (std::min)(i0 + tile, pending.request.m), j1 = (std::min)(j0 + tile, pending.request.n);
+                thread_local std::vector<int> acc;
+                acc.resize(size_t(block) * block);
+                for (int i = i0; i < i1; i += block) {
+                    for (int j = j0; j < j1; j += block) {
+                        BlockedMul_epilogue_tile<PlusTimes>(pending.a(), pending.b(), pending.c(), StoreEpilogue{}, acc,
+                                                            i, (std::min)(i + block, i1), j, (std::min)(j + block, j1), block);
+                    }
+                }
+            };
+            batches_++;
+            in_flight_++;
+            const bool batched = shared->size() > 1;
+            if (batched) batched_requests_ += shared->size();
+            MulFuture future(job);
+            future.then([this, shared, batched](const Mat&) {
+                auto now = std::chrono::steady_clock::now();
+                for (const auto& pending : *shared) {
+                    long long us = std::chrono::duration_cast<std::chrono::microseconds>(now - pending->received).count();
+                    (batched ? batched_latency_ : direct_latency_).record(us);
+                    service::Reply reply{pending->request.id, 0, static_cast<int32_t>(shared->size()), us};
+                    pending->connection->send(&reply, sizeof(reply));
+                }
+                in_flight_--;
+            });
+            pool_.submit(job);
+        }
+
+        ServiceConfig config_;
+        int listen_fd_ = -1;
+        std::atomic<bool> stopping_{false};
+        std::map<Shape, Batch> waiting_;
+        LatencyHistogram batched_latency_, direct_latency_;
+        std::atomic<unsigned long long> requests_{0}, batches_{0}, batched_requests_{0};
+        std::atomic<int> in_flight_{0};
+        MulPool pool_;    // last, so it drains before the state its continuations use is destroyed
+    };
+
+    // A, B and C of one request in a shared memory segment the client fills and reads in place
+    class SharedOperands {
+    public:
+        SharedOperands(int m, int k, int n) : m_(m), k_(k), n_(n) {
+            if (m < 0 || k < 0 || n < 0 || !service::segmentBytes(m, k, n, bytes_)) {
+                throw std::invalid_argument("operand shapes too large for a shared memory segment");
+            }
+            fd_ = service::createSegment(bytes_);
+            if (bytes_) {
+                base_ = static_cast<int*>(mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0));
+                if (base_ == MAP_FAILED) {
+                    close(fd_);
+                    throw std::runtime_error("mmap failed on shared memory segment");
+                }
+            }
+        }
+        ~SharedOperands() {
+            if (bytes_) munmap(base_, bytes_);
+            close(fd_);
+        }
+        SharedOperands(const SharedOperands&) = delete;
+        SharedOperands& operator=(const SharedOperands&) = delete;
+
+        int* a() { return base_; }
+        int* b() { return base_ + size_t(m_) * k_; }
+        MatView c() const { return MatView(m_, n_, base_ + size_t(m_) * k_ + size_t(k_) * n_); }
+        int fd() const { return fd_; }
+        int m() const { return m_; }
+        int k() const { return k_; }
+        int n() const { return n_; }
+
+    private:
+        int m_, k_, n_;
+        size_t bytes_ = 0;
+        int fd_ = -1;
+        int* base_ = nullptr;
+    };
+
+    class ServiceClient {
+    public:
+        explicit ServiceClient(const std::string& socket_path) {
+            sockaddr_un addr = service::socketAddress(socket_path);
+            fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+            if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+                if (fd_ >= 0) close(fd_);
+                throw std::runtime_error("cannot connect to " + socket_path);
+            }
+        }
+        ~ServiceClient() { close(fd_); }
+        ServiceClient(const ServiceClient&) = delete;
+        ServiceClient& operator=(const ServiceClient&) = delete;
+
+        // Send without waiting; replies may come back in any order and carry the id
+        void submit(const SharedOperands& operands, uint64_t id) {
+            service::Request request{uint32_t(service::Op::Multiply), 0, id, operands.m(), operands.k(), operands.n(), 0};
+            if (!service::sendMessage(fd_, &request, sizeof(request), operands.fd())) throw std::runtime_error("send failed");
+        }
+
+        // Replies to submitted requests, in completion order
+        service::Reply receive() {
+            service::Reply reply{};
+            int fd = -1;
+            if (service::receiveMessage(fd_, &reply, sizeof(reply), fd) != sizeof(reply)) throw std::runtime_error("service closed");
+            if (fd >= 0) close(fd);
+            return reply;
+        }
+
+        // Blocking convenience: copies the operands in and the product out
+        Mat multiply(MatView mat1, MatView mat2) {
+            if (mat1.cols != mat2.rows) throw std::invalid_argument("operand shapes do not match");
+            SharedOperands operands(mat1.rows, mat1.cols, mat2.cols);
+            std::copy(mat1.matrix, mat1.matrix + size_t(mat1.rows) * mat1.cols, operands.a());
+            std::copy(mat2.matrix, mat2.matrix + size_t(mat2.rows) * mat2.cols, operands.b());
+            submit(operands, 0);
+            if (receive().status != 0) throw std::runtime_error("request rejected");
+            Mat result(mat1.rows, mat2.cols);
+            std::copy(operands.c().matrix, operands.c().matrix + result.matrix.size(), result.matrix.begin());
+            return result;
+        }
+
+        // Only with no requests outstanding, or a pending reply would be read as the stats
+        service::StatsReply stats() {
+            service::Request request{uint32_t(service::Op::Stats), 0, 0, 0, 0, 0, 0};
+            service::sendMessage(fd_, &request, sizeof(request));
+            service::StatsReply stats{};
+            int fd = -1;
+            if (service::receiveMessage(fd_, &stats, sizeof(stats), fd) != sizeof(stats)) throw std::runtime_error("service closed");
+            return stats;
+        }
+
+        void shutdown() {
+            service::Request request{uint32_t(service::Op::Shutdown), 0, 0, 0, 0, 0, 0};
+            service::sendMessage(fd_, &request, sizeof(request));
+        }
+
+    private:
+        int fd_ = -1;
+    };
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+
+// Matrix powers A^k by repeated squaring (right-to-left binary exponentiation) over any semiring.
+// Three n x n buffers are allocated up front: the running result, the current square A^(2^i) and
+// a scratch. Every step writes its product into the scratch and swaps it in, so no step allocates.
+// Powers of a symmetric A stay symmetric, and then A * A = A * A^T: its squarings go through the
+// SYRK kernel, which computes only the lower triangle. Everything else uses the threaded blocked
+// multiply writing straight into the scratch.
+
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "Rec_MatMul.h"
+#include "syrk.h"
+
+namespace MatMath {
+
+    struct MatPowStats {
+        int squarings = 0;
+        int multiplies = 0;                     // result * square steps
+        bool symmetric = false;                 // squarings used the SYRK kernel
+        std::vector<long long> squaring_us;     // time of each squaring
+    };
+
+    bool isSymmetric(MatView mat) {
+        if (mat.rows != mat.cols) return false;
+        for (int i = 0; i < mat.rows; i++)
+            for (int j = 0; j < i; j++)
+                if (mat.matrix[size_t(i) * mat.cols + j] != mat.matrix[size_t(j) * mat.cols + i]) return false;
+        return true;
+    }
+
+    // Semiring identity: one() on the diagonal, zero() elsewhere
+    template <class S = PlusTimes>
+    Mat identityMat(int n) {
+        Mat result = semiringZeros<S>(n, n);
+        for (int i = 0; i < n; i++) result.matrix[size_t(i) * n + i] = S::one();
+        return result;
+    }
+
+    template <class S = PlusTimes>
+    Mat matPow(MatView mat, unsigned long long k, const ThreadConfig& config = {}, MatPowStats* stats = nullptr) {
+        if (mat.rows != mat.cols) throw std::invalid_argument("matPow needs a square matrix");
+        const int n = mat.rows;
+        if (k == 0) return identityMat<S>(n);
+
+        const int scratch_n = k > 1 ? n : 0;
+        Mat result(n, n), square(n, n), scratch(scratch_n, scratch_n);
+        MulWorkspace workspace;
+        std::copy(mat.matrix, mat.matrix + square.matrix.size(), square.matrix.begin());
+        const bool symmetric = k > 1 && isSymmetric(mat);
+        if (stats) stats->symmetric = symmetric;
+        bool have_result = false;
+        for (;;) {
+            if (k & 1) {
+                if (!have_result) {
+                    result.matrix = square.matrix;
+                    have_result = true;
+                } else {
+                    BlockedMul_threading<S>(result, square, scratch, BLOCK_SIZE, config, Update::Overwrite, &workspace);
+                    std::swap(result, scratch);
+                    if (stats) stats->multiplies++;
+                }
+            }
+            k >>= 1;
+            if (!k) break;
+
+            auto start = std::chrono::steady_clock::now();
+            if (symmetric) SyrkBlocked_threading<S>(square, scratch, BLOCK_SIZE, config);
+            else BlockedMul_threading<S>(square, square, scratch, BLOCK_SIZE, config, Update::Overwrite, &workspace);
+            std::swap(square, scratch);
+            if (stats) {
+                stats->squarings++;
+                stats->squaring_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+            }
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <cmath>
+#include "Rec_MatMul.h"
+#include "mapped_file.h"
+
+// Row-major int matrix stored in a file and accessed through mmap, so it never has to fit in RAM.
+// The elements start `offset` bytes into the file.
+struct FileMat {
+    int rows = 0, cols = 0;
+    size_t offset = 0;
+    MappedFile file;
+
+    int* data() const { return reinterpret_cast<int*>(file.data() + offset); }
+    size_t rowBytes() const { return size_t(cols) * sizeof(int); }
+
+    // Create (or overwrite) a zero-filled rows x cols matrix file
+    static FileMat create(const std::string& path, int rows, int cols) {
+        FileMat mat;
+        mat.rows = rows;
+        mat.cols = cols;
+        mat.file = MappedFile(path, true, size_t(rows) * cols * sizeof(int));
+        return mat;
+    }
+
+    static FileMat open(const std::string& path, int rows, int cols, size_t offset = 0) {
+        FileMat mat;
+        mat.rows = rows;
+        mat.cols = cols;
+        mat.offset = offset;
+        mat.file = MappedFile(path, false);
+        if (mat.file.size() < offset + size_t(rows) * cols * sizeof(int)) {
+            throw std::runtime_error(path + " is smaller than a " + std::to_string(rows) + "x" +
+                                     std::to_string(cols) + " matrix");
+        }
+        return mat;
+    }
+
+    static FileMat fromMat(const std::string& path, MatView mat) {
+        FileMat out = create(path, mat.rows, mat.cols);
+        if (out.file.data()) std::memcpy(out.data(), mat.matrix, size_t(mat.rows) * mat.cols * sizeof(int));
+        out.file.flush(0, out.file.size());
+        return out;
+    }
+};
+
+struct OocStats {
+    int tile = 0;                 // out-of-core tile edge, in elements
+    long long bytes_read = 0;     // A and B tile bytes copied out of the mappings
+    long long bytes_written = 0;  // C tile bytes written back
+};
+
+namespace MatMath {
+
+    namespace ooc {
+        // Advise every row segment of the [r0, r1) x [c0, c1) tile
+        void adviseTile(const FileMat& mat, int r0, int r1, int c0, int c1, MappedFile::Advice advice) {
+            if (c0 == 0 && c1 == mat.cols) {  // full-width rows are one contiguous range
+                mat.file.advise(mat.offset + size_t(r0) * mat.rowBytes(), size_t(r1 - r0) * mat.rowBytes(), advice);
+                return;
+            }
+            for (int r = r0; r < r1; r++) {
+                mat.file.advise(mat.offset + (size_t(r) * mat.cols + c0) * sizeof(int),
+                                size_t(c1 - c0) * sizeof(int), advice);
+            }
+        }
+
+        void loadTile(const FileMat& mat, Mat& tile, int r0, int c0) {
+            for (int r = 0; r < tile.rows; r++) {
+                std::memcpy(tile.matrix.data() + size_t(r) * tile.cols,
+                            mat.data() + size_t(r0 + r) * mat.cols + c0, size_t(tile.cols) * sizeof(int));
+            }
+        }
+    }
+
+    // Same sizing rule as BLOCK_SIZE, applied to a RAM budget instead of L1:
+    // three T x T int tiles (A, B and C) must fit, T rounded down to a multiple of BLOCK_SIZE when larger.
+    int oocTileSize(size_t memory_budget_bytes) {
+        int tile = (std::max)(64, static_cast<int>(std::sqrt(static_cast<double>(memory_budget_bytes) / 12)));
+        return tile >= BLOCK_SIZE ? tile / BLOCK_SIZE * BLOCK_SIZE : tile;
+    }
+
+    // Out-of-core blocked multiply: C (a file) = A * B (files). The i, j, k tile loop of BlockedMul
+    // runs over RAM-sized tiles; each C tile stays in memory across the whole k loop and is written
+    // back once, so A is read col_tiles times and B row_tiles times. The next k step's tiles are
+    // prefetched with MADV_WILLNEED while the current ones are multiplied. Consumed A and B tiles,
+    // and each band of C rows once it is complete and flushed, are released from the mapping and
+    // the page cache (madvise + posix_fadvise DONTNEED), so resident memory stays near the budget;
+    // C pages still being written back leave the page cache only when the write completes.
+    void BlockedMul_ooc(const FileMat& mat1, const FileMat& mat2, FileMat& result,
+                        size_t memory_budget_bytes, OocStats* stats = nullptr) {
+        using enum MappedFile::Advice;
+        if (mat1.cols != mat2.rows) throw std::invalid_argument("operand shapes do not match");
+        if (result.rows != mat1.rows || result.cols != mat2.cols) {
+            throw std::invalid_argument("result shape does not match the product");
+        }
+        OocStats local;
+        int T = oocTileSize(memory_budget_bytes);
+        local.tile = T;
+
+        for (int i = 0; i < mat1.rows; i += T) {
+            int i_end = (std::min)(i + T, mat1.rows);
+            for (int j = 0; j < mat2.cols; j += T) {
+                int j_end = (std::min)(j + T, mat2.cols);
+                Mat c_tile(i_end - i, j_end - j);
+
+                if (mat1.cols > 0) {
+                    ooc::adviseTile(mat1, i, i_end, 0, (std::min)(T, mat1.cols), WillNeed);
+                    ooc::adviseTile(mat2, 0, (std::min)(T, mat2.rows), j, j_end, WillNeed);
+                }
+                for (int k = 0; k < mat1.cols; k += T) {
+                    int k_end = (std::min)(k + T, mat1.cols);
+                    if (k_end < mat1.cols) {
+                        int k_next = (std::min)(k_end + T, mat1.cols);
+                        ooc::adviseTile(mat1, i, i_end, k_end, k_next, WillNeed);
+                        ooc::adviseTile(mat2, k_end, k_next, j, j_end, WillNeed);
+                    }
+
+                    Mat a_tile(i_end - i, k_end - k);
+                    Mat b_tile(k_end - k, j_end - j);
+                    ooc::loadTile(mat1, a_tile, i, k);
+                    ooc::loadTile(mat2, b_tile, k, j);
+                    local.bytes_read += (a_tile.matrix.size() + b_tile.matrix.size()) * sizeof(int);
+
+                    for (int ii = 0; ii < c_tile.rows; ii += BLOCK_SIZE) {
+                        for (int jj = 0; jj < c_tile.cols; jj += BLOCK_SIZE) {
+                            BlockedMul_tile(a_tile, b_tile, c_tile, BLOCK_SIZE, ii, jj, 0, a_tile.cols);
+                        }
+                    }
+
+                    ooc::adviseTile(mat1, i, i_end, k, k_end, DontNeed);
+                    ooc::adviseTile(mat2, k, k_end, j, j_end, DontNeed);
+                }
+
+                for (int r = 0; r < c_tile.rows; r++) {
+                    std::memcpy(result.data() + size_t(i + r) * result.cols + j,
+                                c_tile.matrix.data() + size_t(r) * c_tile.cols, size_t(c_tile.cols) * sizeof(int));
+                }
+                local.bytes_written += c_tile.matrix.size() * sizeof(int);
+                result.file.flush(result.offset + size_t(i) * result.rowBytes(), size_t(i_end - i) * result.rowBytes());
+            }
+            result.file.advise(result.offset + size_t(i) * result.rowBytes(), size_t(i_end - i) * result.rowBytes(), DontNeed);
+        }
+        if (stats) *stats = local;
+    }
+
+}
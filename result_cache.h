@@ -0,0 +1,233 @@
+#pragma once
+
+// Memoized products: an LRU cache of results in front of the multiply kernels.
+// A product is keyed by a 64-bit content hash of each operand, the shapes, the semiring and the
+// kernel, so a repeated pair (a fixed weight matrix against a recurring input) is answered by
+// hashing the operands and copying the stored result instead of multiplying again. Entries are
+// bounded by the bytes of their results; the least recently used ones are evicted first.
+// The hash streams the operand once at memory speed: eight independent 64-bit lanes each fold in
+// (x ^ key) lo32 * hi32 of one word plus its neighbour, as in XXH3, with a multiply scramble every
+// 2 KB; the AVX2 path computes exactly the same lanes as the scalar one, two registers at a time.
+// Results are not compared against recomputation, so two different pairs colliding on both
+// 64-bit hashes and all shapes would share an entry.
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <typeinfo>
+#include <unordered_map>
+#include "Rec_MatMul.h"
+#include "chain.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define MATMUL_X86_DISPATCH 1
+#endif
+
+namespace MatMath {
+
+    namespace hash {
+
+        const int LANES = 8;
+        const size_t STRIPE_BYTES = LANES * sizeof(uint64_t);
+        const size_t STRIPES_PER_BLOCK = 32;   // scramble every 2 KB
+        const uint64_t PRIME32 = 0x9E3779B1ULL;
+        const uint64_t KEYS[LANES] = {0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+                                      0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL};
+
+        uint64_t mix(uint64_t x) {
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ULL;
+            return x ^ (x >> 33);
+        }
+
+        // Whole stripes of `data` into the lanes
+        void accumulateScalar(uint64_t* acc, const unsigned char* data, size_t stripes) {
+            for (size_t s = 0; s < stripes; s++) {
+                uint64_t words[LANES];
+                std::memcpy(words, data + s * STRIPE_BYTES, STRIPE_BYTES);
+                for (int l = 0; l < LANES; l++) {
+                    uint64_t keyed = words[l] ^ KEYS[l];
+                    acc[l] += words[l ^ 1] + (keyed & 0xffffffffULL) * (keyed >> 32);
+                }
+                if ((s + 1) % STRIPES_PER_BLOCK == 0) {
+                    for (int l = 0; l < LANES; l++) acc[l] = (acc[l] ^ (acc[l] >> 47) ^ KEYS[l]) * PRIME32;
+                }
+            }
+        }
+
+#ifdef MATMUL_X86_DISPATCH
+        __attribute__((target("avx2")))
+        inline __m256i stepAvx2(__m256i acc, __m256i words, __m256i key) {
+            __m256i keyed = _mm256_xor_si256(words, key);
+            __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+            __m256i swapped = _mm256_shuffle_epi32(words, _MM_SHUFFLE(1, 0, 3, 2));
+            return _mm256_add_epi64(acc, _mm256_add_epi64(swapped, product));
+        }
+
+        // (acc ^ acc >> 47 ^ key) * PRIME32, the 64-bit product built from two 32 x 32 multiplies
+        __attribute__((target("avx2")))
+        inline __m256i scrambleAvx2(__m256i acc, __m256i key, __m256i prime) {
+            acc = _mm256_xor_si256(_mm256_xor_si256(acc, _mm256_srli_epi64(acc, 47)), key);
+            __m256i low = _mm256_mul_epu32(acc, prime);
+            __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(acc, 32), prime);
+            return _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+        }
+
+        __attribute__((target("avx2")))
+        void accumulateAvx2(uint64_t* acc, const unsigned char* data, size_t stripes) {
+            __m256i acc0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc));
+            __m256i acc1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + 4));
+            const __m256i key0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(KEYS));
+            const __m256i key1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(KEYS + 4));
+            const __m256i prime = _mm256_set1_epi64x(static_cast<long long>(PRIME32));
+            for (size_t s = 0; s < stripes; s++) {
+                const unsigned char* stripe = data + s * STRIPE_BYTES;
+                acc0 = stepAvx2(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stripe)), key0);
+                acc1 = stepAvx2(acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stripe + 32)), key1);
+                if ((s + 1) % STRIPES_PER_BLOCK == 0) {
+                    acc0 = scrambleAvx2(acc0, key0, prime);
+                    acc1 = scrambleAvx2(acc1, key1, prime);
+                }
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc), acc0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + 4), acc1);
+        }
+#endif
+
+        bool avx2Supported() {
+#ifdef MATMUL_X86_DISPATCH
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        }
+    }
+
+    // Hash of a matrix's shape and contents; `simd` picks the AVX2 lanes when the CPU has them
+    uint64_t contentHash(MatView mat, bool simd = true) {
+        using namespace hash;
+        static const bool avx2 = avx2Supported();
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(mat.matrix);
+        const size_t bytes = size_t(mat.rows) * mat.cols * sizeof(int);
+        const size_t stripes = bytes / STRIPE_BYTES;
+
+        uint64_t acc[LANES];
+        for (int l = 0; l < LANES; l++) acc[l] = KEYS[l] ^ (uint64_t(uint32_t(mat.rows)) << 32 | uint32_t(mat.cols));
+#ifdef MATMUL_X86_DISPATCH
+        if (simd && avx2) accumulateAvx2(acc, data, stripes);
+        else accumulateScalar(acc, data, stripes);
+#else
+        accumulateScalar(acc, data, stripes);
+#endif
+        // Tail of fewer than 16 ints, one 4-byte word at a time
+        uint64_t result = bytes * PRIME32;
+        for (size_t offset = stripes * STRIPE_BYTES; offset < bytes; offset += sizeof(int)) {
+            uint32_t word;
+            std::memcpy(&word, data + offset, sizeof(word));
+            result = mix(result ^ (word + offset));
+        }
+        for (int l = 0; l < LANES; l++) result = mix(result ^ acc[l]) + KEYS[l];
+        return mix(result);
+    }
+
+    struct CacheStats {
+        unsigned long long hits = 0, misses = 0, evictions = 0;
+        size_t entries = 0, bytes = 0;
+    };
+
+    class ResultCache {
+    public:
+        explicit ResultCache(size_t capacity_bytes) : capacity_(capacity_bytes) {}
+
+        // A * B from the cache, or computed with `kernel` and stored
+        template <class S = PlusTimes>
+        Mat multiply(MatView mat1, MatView mat2, ChainKernel kernel = ChainKernel::Blocked, const ThreadConfig& config = {}) {
+            if (mat1.cols != mat2.rows) throw std::invalid_argument("operand shapes do not match");
+            Key key{contentHash(mat1), contentHash(mat2), mat1.rows, mat1.cols, mat2.cols,
+                    static_cast<int>(kernel), typeid(S).hash_code()};
+            if (std::shared_ptr<const Mat> cached = find(key)) return *cached;
+
+            auto result = std::make_shared<Mat>(kernel == ChainKernel::Recursive ? matMul<S>(mat1, mat2)
+                                                                                   : BlockedMul_threading<S>(mat1, mat2, BLOCK_SIZE, config));
+            insert(key, result);
+            return *result;
+        }
+
+        CacheStats stats() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            CacheStats stats = stats_;
+            stats.entries = entries_.size();
+            stats.bytes = bytes_;
+            return stats;
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entries_.clear();
+            index_.clear();
+            bytes_ = 0;
+        }
+
+    private:
+        struct Key {
+            uint64_t hash1, hash2;
+            int rows, inner, cols;
+            int kernel;
+            size_t semiring;
+            bool operator==(const Key& other) const {
+                return hash1 == other.hash1 && hash2 == other.hash2 && rows == other.rows && inner == other.inner &&
+                       cols == other.cols && kernel == other.kernel && semiring == other.semiring;
+            }
+        };
+        struct KeyHash {
+            size_t operator()(const Key& key) const { return static_cast<size_t>(hash::mix(key.hash1 ^ (key.hash2 * hash::PRIME32) ^ key.semiring)); }
+        };
+        struct Entry {
+            Key key;
+            std::shared_ptr<const Mat> result;
+            size_t bytes;
+        };
+
+        // The stored result, moved to the front of the LRU order
+        std::shared_ptr<const Mat> find(const Key& key) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = index_.find(key);
+            if (found == index_.end()) {
+                stats_.misses++;
+                return nullptr;
+            }
+            stats_.hits++;
+            entries_.splice(entries_.begin(), entries_, found->second);
+            return found->second->result;
+        }
+
+        void insert(const Key& key, std::shared_ptr<const Mat> result) {
+            const size_t bytes = result->matrix.size() * sizeof(int) + sizeof(Entry);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (bytes > capacity_ || index_.count(key)) return;
+            while (bytes_ + bytes > capacity_) {
+                bytes_ -= entries_.back().bytes;
+                index_.erase(entries_.back().key);
+                entries_.pop_back();
+                stats_.evictions++;
+            }
+            entries_.push_front(Entry{key, std::move(result), bytes});
+            index_[key] = entries_.begin();
+            bytes_ += bytes;
+        }
+
+        size_t capacity_;
+        size_t bytes_ = 0;
+        std::list<Entry> entries_;      // most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+        CacheStats stats_;
+        mutable std::mutex mutex_;
+    };
+
+}
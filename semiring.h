@@ -0,0 +1,114 @@
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+// Compile-time semiring policies for the multiply kernels.
+// A policy supplies the additive identity zero(), the multiplicative identity one(), the "sum" add()
+// and the "product" mul();
+// the recursive and blocked schedules only ever combine elements through these.
+// A policy may also declare a wider accumulator (acc_t, acc_zero, accumulate, reduce) that
+// the kernels use for dot products instead of add/mul; see Accumulator below.
+namespace Semiring {
+
+    // Ordinary arithmetic (+, *)
+    struct PlusTimes {
+        static int zero() { return 0; }
+        static int one() { return 1; }
+        static int add(int a, int b) { return a + b; }
+        static int mul(int a, int b) { return a * b; }
+    };
+
+    // Tropical (min, +) for shortest paths. Values >= INF mean "no edge"; inputs must lie in
+    // [-INF, INF] so a single product cannot overflow, and results never exceed INF.
+    struct MinPlus {
+        static const int INF = INT_MAX / 2;
+        static int zero() { return INF; }
+        static int one() { return 0; }
+        static int add(int a, int b) { return (std::min)(a, b); }
+        static int mul(int a, int b) { return a + b; }
+    };
+
+    // (max, +) for longest/critical paths, the mirror of MinPlus with -INF as "no edge"
+    struct MaxPlus {
+        static const int INF = INT_MAX / 2;
+        static int zero() { return -INF; }
+        static int one() { return 0; }
+        static int add(int a, int b) { return (std::max)(a, b); }
+        static int mul(int a, int b) { return a + b; }
+    };
+
+    // Boolean (or, and) for reachability. Any nonzero input is true; results are 0 or 1.
+    struct OrAnd {
+        static int zero() { return 0; }
+        static int one() { return 1; }
+        static int add(int a, int b) { return a | b; }
+        static int mul(int a, int b) { return (a != 0) & (b != 0); }
+    };
+
+    // High 64 bits of a 64 x 64-bit product
+    inline uint64_t mulhi64(uint64_t a, uint64_t b) {
+#ifdef _MSC_VER
+        return __umulh(a, b);
+#else
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#endif
+    }
+
+    // Integers modulo a prime P < 2^31; inputs must already lie in [0, P) (see reduceMod).
+    // Dot products accumulate unreduced 62-bit products in 64 bits and fold only when the top bit
+    // is set, i.e. when the next product could overflow; the final value is reduced with Barrett.
+    template <uint32_t P>
+    struct ModP {
+        static_assert(P > 1 && P < (1u << 31), "modulus must fit in 31 bits");
+        using acc_t = uint64_t;
+
+        static constexpr uint64_t BARRETT = ~uint64_t(0) / P;            // floor((2^64 - 1) / P)
+        static constexpr uint64_t FOLD = (uint64_t(1) << 63) / P * P;    // largest multiple of P <= 2^63
+
+        static int reduce(uint64_t x) {
+            uint64_t r = x - mulhi64(x, BARRETT) * P;
+            while (r >= P) r -= P;
+            return static_cast<int>(r);
+        }
+
+        static int zero() { return 0; }
+        static int one() { return 1; }
+        static int add(int a, int b) {
+            uint32_t sum = uint32_t(a) + uint32_t(b);
+            return static_cast<int>(sum >= P ? sum - P : sum);
+        }
+        static int mul(int a, int b) { return reduce(uint64_t(uint32_t(a)) * uint32_t(b)); }
+
+        static acc_t acc_zero() { return 0; }
+        static acc_t accumulate(acc_t acc, int a, int b) {
+            acc += uint64_t(uint32_t(a)) * uint32_t(b);   // < 2^63 + P + 2^62, cannot wrap
+            return (acc >> 63) ? acc - FOLD : acc;
+        }
+    };
+
+    // How kernels accumulate a dot product under S: through add/mul by default, or through the
+    // policy's own wider accumulator when it declares one
+    template <class S>
+    struct Accumulator {
+        using type = int;
+        static int zero() { return S::zero(); }
+        static int step(int acc, int a, int b) { return S::add(acc, S::mul(a, b)); }
+        static int finish(int acc) { return acc; }
+    };
+
+    template <class S>
+        requires requires { typename S::acc_t; }
+    struct Accumulator<S> {
+        using type = typename S::acc_t;
+        static type zero() { return S::acc_zero(); }
+        static type step(type acc, int a, int b) { return S::accumulate(acc, a, b); }
+        static int finish(type acc) { return S::reduce(acc); }
+    };
+
+}
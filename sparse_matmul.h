@@ -0,0 +1,183 @@
+#pragma once
+
+// Compressed sparse row (CSR) matrices and the sparse x dense product.
+// Each row of C is the sum of the rows of B selected by the nonzeros of the matching row of A,
+// scaled by their values, so the work is nnz(A) * cols(B) instead of rows * cols * cols(B).
+// AutoMul samples the density of A and takes this path below a crossover density measured once
+// on this machine against the threaded blocked multiply, per shape class and thread placement.
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "Rec_MatMul.h"
+
+struct CsrMat {
+    int rows, cols;
+    std::vector<size_t> row_ptr;  // rows + 1 offsets into col_idx / values
+    std::vector<int> col_idx;
+    std::vector<int> values;
+
+    size_t nnz() const { return values.size(); }
+    double density() const { return rows && cols ? double(nnz()) / (double(rows) * cols) : 0.0; }
+
+    // Nonzeros are counted per row in parallel, then copied into their prefix-sum slots
+    static CsrMat fromMat(MatView mat, const ThreadConfig& config = {}) {
+        CsrMat out{mat.rows, mat.cols, std::vector<size_t>(size_t(mat.rows) + 1, 0), {}, {}};
+        int thread_count = resolveThreadCount(config);
+        MatMath::runWorkers(config, [&](int t) {
+            for (int i = t; i < mat.rows; i += thread_count) {
+                const int* row = mat.matrix + size_t(i) * mat.cols;
+                size_t count = 0;
+                for (int j = 0; j < mat.cols; j++) count += row[j] != 0;
+                out.row_ptr[i + 1] = count;
+            }
+        });
+        for (int i = 0; i < mat.rows; i++) out.row_ptr[i + 1] += out.row_ptr[i];
+        out.col_idx.resize(out.row_ptr.back());
+        out.values.resize(out.row_ptr.back());
+        MatMath::runWorkers(config, [&](int t) {
+            for (int i = t; i < mat.rows; i += thread_count) {
+                const int* row = mat.matrix + size_t(i) * mat.cols;
+                size_t p = out.row_ptr[i];
+                for (int j = 0; j < mat.cols; j++) {
+                    if (row[j] != 0) {
+                        out.col_idx[p] = j;
+                        out.values[p++] = row[j];
+                    }
+                }
+            }
+        });
+        return out;
+    }
+
+    Mat toMat() const {
+        Mat out(rows, cols);
+        for (int i = 0; i < rows; i++) {
+            for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; p++) out.matrix[size_t(i) * cols + col_idx[p]] = values[p];
+        }
+        return out;
+    }
+};
+
+// Fraction of nonzero entries, estimated from up to `samples` positions spread by a
+// multiplicative hash so row- or column-periodic patterns do not alias with the stride
+double sampleDensity(MatView mat, int samples = 4096) {
+    uint64_t total = uint64_t(mat.rows) * mat.cols;
+    if (total == 0) return 0.0;
+    if (total <= uint64_t(samples)) {
+        uint64_t nonzero = 0;
+        for (uint64_t n = 0; n < total; n++) nonzero += mat.matrix[n] != 0;
+        return double(nonzero) / total;
+    }
+    int nonzero = 0;
+    for (int s = 0; s < samples; s++) {
+        uint64_t n = (uint64_t(s) * 0x9E3779B97F4A7C15ull) % total;
+        nonzero += mat.matrix[n] != 0;
+    }
+    return double(nonzero) / samples;
+}
+
+namespace MatMath {
+
+    // C = A * B with A sparse. Rows of C are handed out in chunks; within a row, columns are
+    // taken BLOCK_SIZE at a time so the partial row of C stays in L1 while the B rows stream past.
+    Mat SpMM(const CsrMat& mat1, MatView mat2, const ThreadConfig& config = {}) {
+        if (mat1.cols != mat2.rows) throw std::invalid_argument("operand shapes do not match");
+        Mat result(mat1.rows, mat2.cols);
+        const int CHUNK = 16;
+        std::atomic<int> next_row{0};
+        runWorkers(config, [&](int) {
+            for (int i0 = next_row.fetch_add(CHUNK); i0 < mat1.rows; i0 = next_row.fetch_add(CHUNK)) {
+                int i1 = (std::min)(i0 + CHUNK, mat1.rows);
+                for (int i = i0; i < i1; i++) {
+                    int* c_row = result.matrix.data() + size_t(i) * result.cols;
+                    for (int j0 = 0; j0 < mat2.cols; j0 += BLOCK_SIZE) {
+                        int j1 = (std::min)(j0 + BLOCK_SIZE, mat2.cols);
+                        for (size_t p = mat1.row_ptr[i]; p < mat1.row_ptr[i + 1]; p++) {
+                            const int value = mat1.values[p];
+                            const int* b_row = mat2.matrix + size_t(mat1.col_idx[p]) * mat2.cols;
+                            for (int j = j0; j < j1; j++) c_row[j] += value * b_row[j];
+                        }
+                    }
+                }
+            }
+        });
+        return result;
+    }
+
+    // Probe edge for one dimension: the next power of two, clamped to [64, 512] to bound probe time
+    int crossoverProbeSize(int n) {
+        int size = 64;
+        while (size < n && size < 512) size *= 2;
+        return size;
+    }
+
+    // Density of an M x K A, times a K x N B, below which converting A to CSR and running SpMM beats
+    // BlockedMul_threading. Measured on a probe of the caller's shape class (each dimension rounded
+    // up to a power of two, see crossoverProbeSize), stepping the density up until the sparse path
+    // (conversion included) is no longer faster, and interpolating between the last two steps; 1.0
+    // if it wins even on a full matrix. Both paths scale differently with shape and threads, so the
+    // result is cached per shape class, thread count, affinity policy and CPU list.
+    double sparseCrossover(int rows, int inner, int cols, const ThreadConfig& config = {}) {
+        static std::mutex mutex;
+        static std::map<std::tuple<int, int, int, int, AffinityPolicy, std::vector<int>>, double> measured;
+        const int M = crossoverProbeSize(rows), K = crossoverProbeSize(inner), N = crossoverProbeSize(cols);
+        const auto key = std::make_tuple(M, K, N, resolveThreadCount(config), config.policy, config.cpu_list);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = measured.find(key);
+        if (found != measured.end()) return found->second;
+
+        const double crossover = [&] {
+            const double densities[] = {0.005, 0.01, 0.02, 0.05, 0.1, 0.15, 0.2, 0.3, 0.4, 0.5, 0.75, 1.0};
+            Mat b(K, N);
+            for (size_t n = 0; n < b.matrix.size(); n++) b.matrix[n] = int(n % 97) + 1;
+
+            auto time_us = [](auto&& run) {
+                long long best = -1;
+                for (int rep = 0; rep < 3; rep++) {
+                    auto start = std::chrono::steady_clock::now();
+                    run();
+                    long long us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start).count();
+                    if (best < 0 || us < best) best = us;
+                }
+                return double(best);
+            };
+            Mat full(M, K);
+            for (size_t n = 0; n < full.matrix.size(); n++) full.matrix[n] = int(n % 13) + 1;
+            double dense_time = time_us([&] { BlockedMul_threading(full, b, BLOCK_SIZE, config); });
+
+            double previous_density = 0, previous_ratio = 0;
+            for (double density : densities) {
+                Mat a(M, K);
+                uint32_t threshold = static_cast<uint32_t>(density * 4294967295.0);
+                for (size_t n = 0; n < a.matrix.size(); n++) {
+                    if (uint32_t(n * 2654435761u) <= threshold) a.matrix[n] = int(n % 13) + 1;
+                }
+                double ratio = time_us([&] { SpMM(CsrMat::fromMat(a, config), b, config); }) / dense_time;
+                if (ratio >= 1.0) {
+                    if (previous_density == 0) return density;
+                    return previous_density + (density - previous_density) * (1.0 - previous_ratio) / (ratio - previous_ratio);
+                }
+                previous_density = density;
+                previous_ratio = ratio;
+            }
+            return 1.0;
+        }();
+        measured.emplace(key, crossover);
+        return crossover;
+    }
+
+    // A * B through SpMM when A is sparse enough, otherwise the threaded blocked multiply
+    Mat AutoMul(MatView mat1, MatView mat2, const ThreadConfig& config = {}) {
+        if (sampleDensity(mat1) < sparseCrossover(mat1.rows, mat1.cols, mat2.cols, config)) {
+            return SpMM(CsrMat::fromMat(mat1, config), mat2, config);
+        }
+        return BlockedMul_threading(mat1, mat2, BLOCK_SIZE, config);
+    }
+
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+// Triangular and banded matrices stored without their structural zeros, and a blocked multiply
+// by a dense right-hand side that visits only the k tiles each row tile actually touches.
+// Both types expose every row as one contiguous span of columns [first, end), which is all the
+// kernel needs: the k range of a row tile is the union of its rows' spans, and rows only ever
+// read the part of a k tile that lies inside their own span.
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "Rec_MatMul.h"
+
+struct RowSpan {
+    int first, end;         // columns [first, end) are stored
+    const int* values;      // values[j - first] is entry (i, j)
+};
+
+// n x n triangular matrix packed row by row: n (n + 1) / 2 entries
+struct TriMat {
+    int rows, cols;
+    bool lower;
+    std::vector<int> data;
+
+    TriMat(int n, bool is_lower) : rows(n), cols(n), lower(is_lower), data(size_t(n) * (n + 1) / 2, 0) {}
+
+    size_t offset(int i) const {
+        return lower ? size_t(i) * (i + 1) / 2 : size_t(i) * rows - size_t(i) * (i - 1) / 2;
+    }
+    RowSpan row(int i) const { return lower ? RowSpan{0, i + 1, data.data() + offset(i)} : RowSpan{i, cols, data.data() + offset(i)}; }
+    int* rowData(int i) { return data.data() + offset(i); }
+
+    // Entries outside the triangle are dropped
+    static TriMat fromMat(MatView mat, bool lower) {
+        if (mat.rows != mat.cols) throw std::invalid_argument("a triangular matrix must be square");
+        TriMat out(mat.rows, lower);
+        for (int i = 0; i < mat.rows; i++) {
+            RowSpan span = out.row(i);
+            std::copy(mat.matrix + size_t(i) * mat.cols + span.first, mat.matrix + size_t(i) * mat.cols + span.end, out.rowData(i));
+        }
+        return out;
+    }
+};
+
+// rows x cols matrix with `lower_bw` diagonals below the main one and `upper_bw` above,
+// stored as rows x (lower_bw + upper_bw + 1) with entry (i, j) at column j - i + lower_bw
+struct BandMat {
+    int rows, cols;
+    int lower_bw, upper_bw;
+    std::vector<int> data;
+
+    BandMat(int r, int c, int kl, int ku)
+        : rows(r), cols(c), lower_bw(kl), upper_bw(ku), data(size_t(r) * (kl + ku + 1), 0) {}
+
+    int width() const { return lower_bw + upper_bw + 1; }
+    RowSpan row(int i) const {
+        int first = (std::max)(0, i - lower_bw);
+        int end = (std::max)(first, (std::min)(cols, i + upper_bw + 1));
+        return {first, end, data.data() + size_t(i) * width() + (first - (i - lower_bw))};
+    }
+
+    // Entries outside the band are dropped
+    static BandMat fromMat(MatView mat, int lower_bw, int upper_bw) {
+        BandMat out(mat.rows, mat.cols, lower_bw, upper_bw);
+        for (int i = 0; i < mat.rows; i++) {
+            RowSpan span = out.row(i);
+            int* dst = out.data.data() + size_t(i) * out.width() + (span.first - (i - lower_bw));
+            std::copy(mat.matrix + size_t(i) * mat.cols + span.first, mat.matrix + size_t(i) * mat.cols + span.end, dst);
+        }
+        return out;
+    }
+};
+
+// Dense copy with the structural zeros filled in
+template <class S = MatMath::PlusTimes, class Structured>
+Mat toDense(const Structured& mat) {
+    Mat out = MatMath::semiringZeros<S>(mat.rows, mat.cols);
+    for (int i = 0; i < mat.rows; i++) {
+        RowSpan span = mat.row(i);
+        std::copy(span.values, span.values + (span.end - span.first), out.matrix.data() + size_t(i) * mat.cols + span.first);
+    }
+    return out;
+}
+
+namespace MatMath {
+
+    // C[i0:i1, j0:j1] = add(C, A[i0:i1, k0:k1] * B[k0:k1, j0:j1]) over each row's stored span only
+    template <class S = PlusTimes, class Structured>
+    void StructuredTile(const Structured& mat1, MatView mat2, Mat& result, int i0, int i1, int j0, int j1, int k0, int k1) {
+        for (int ii = i0; ii < i1; ii++) {
+            RowSpan span = mat1.row(ii);
+            int* c_row = result.matrix.data() + size_t(ii) * result.cols;
+            int k_begin = (std::max)(k0, span.first), k_end = (std::min)(k1, span.end);
+            for (int kk = k_begin; kk < k_end; kk++) {
+                const int a = span.values[kk - span.first];
+                const int* b_row = mat2.matrix + size_t(kk) * mat2.cols;
+                for (int jj = j0; jj < j1; jj++) c_row[jj] = S::add(c_row[jj], S::mul(a, b_row[jj]));
+            }
+        }
+    }
+
+    // C = A * B for triangular or banded A. Output tiles are handed out most expensive first
+    // (by the number of k tiles their row tile spans); each only visits those k tiles.
+    template <class S = PlusTimes, class Structured>
+    Mat BlockedMul_structured(const Structured& mat1, MatView mat2, const ThreadConfig& config = {}) {
+        if (mat1.cols != mat2.rows) throw std::invalid_argument("operand shapes do not match");
+        Mat result = semiringZeros<S>(mat1.rows, mat2.cols);
+        int row_tiles = (mat1.rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        int col_tiles = (mat2.cols + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        // k range touched by each row tile: the union of its rows' spans
+        struct Task {
+            int ti, tj, k_start, k_end;
+        };
+        std::vector<Task> tasks;
+        for (int tj = 0; tj < col_tiles; tj++) {
+            for (int ti = 0; ti < row_tiles; ti++) {
+                int i0 = ti * BLOCK_SIZE, i1 = (std::min)(i0 + BLOCK_SIZE, mat1.rows);
+                int k_start = mat1.cols, k_end = 0;
+                for (int ii = i0; ii < i1; ii++) {
+                    RowSpan span = mat1.row(ii);
+                    if (span.first < span.end) {
+                        k_start = (std::min)(k_start, span.first);
+                        k_end = (std::max)(k_end, span.end);
+                    }
+                }
+                if (k_start < k_end) tasks.push_back({ti, tj, k_start / BLOCK_SIZE * BLOCK_SIZE, k_end});
+            }
+        }
+        std::stable_sort(tasks.begin(), tasks.end(),
+                         [](const Task& a, const Task& b) { return a.k_end - a.k_start > b.k_end - b.k_start; });
+
+        std::atomic<size_t> next_task{0};
+        runWorkers(config, [&](int) {
+            for (size_t n = next_task++; n < tasks.size(); n = next_task++) {
+                const Task& task = tasks[n];
+                int i0 = task.ti * BLOCK_SIZE, j0 = task.tj * BLOCK_SIZE;
+                for (int k = task.k_start; k < task.k_end; k += BLOCK_SIZE) {
+                    StructuredTile<S>(mat1, mat2, result,
+                                      i0, (std::min)(i0 + BLOCK_SIZE, mat1.rows),
+                                      j0, (std::min)(j0 + BLOCK_SIZE, mat2.cols),
+                                      k, (std::min)(k + BLOCK_SIZE, task.k_end));
+                }
+            }
+        });
+        return result;
+    }
+
+}
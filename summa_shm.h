@@ -0,0 +1,304 @@
+#pragma once
+
+// SUMMA across forked worker processes that exchange panels through POSIX shared memory.
+// Each worker of a q x q grid owns one block of A, B and C in its private memory; at step s
+// worker (r, s) broadcasts its A block along row r and worker (s, c) its B block down column c,
+// and every worker accumulates C(r, c) += A(r, s) * B(s, c).
+// Models a distributed deployment on a single machine: compute and communication time are
+// measured separately per worker.
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include "Rec_MatMul.h"
+
+#ifndef _WIN32
+    #include <csignal>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+struct SummaStats {
+    int grid = 0;                   // workers per grid row/column, q
+    double compute_us_avg = 0;      // local block multiply time
+    double compute_us_max = 0;
+    double comm_us_avg = 0;         // time in send/receive, including waiting for peers
+    double comm_us_max = 0;
+    long long bytes_sent = 0;       // panel bytes written into ring buffers by all workers
+};
+
+#ifndef _WIN32
+
+namespace MatMath {
+
+    namespace summa {
+
+        // Ring of fixed-size slots living in shared memory, with one consumer. Producers take turns:
+        // message n (the panel of SUMMA step n) is written only by its owner, after message n - 1.
+        struct RingHeader {
+            std::atomic<unsigned long long> head; // next slot to write
+            std::atomic<unsigned long long> tail; // next slot to read
+        };
+
+        const int RING_SLOTS = 2; // double buffering lets a sender run one step ahead
+
+        struct Ring {
+            RingHeader* header;
+            char* slots;
+            size_t slot_bytes;
+            const std::atomic<int>* aborted;  // set once any worker fails; waiting then stops
+
+            void checkAborted() const {
+                if (aborted->load(std::memory_order_relaxed)) throw std::runtime_error("SUMMA run aborted");
+            }
+
+            // Slot payload: int rows, int cols, then rows * cols ints
+            void send(const Mat& block, unsigned long long ticket) {
+                while (header->head.load(std::memory_order_acquire) != ticket ||
+                       ticket - header->tail.load(std::memory_order_acquire) >= RING_SLOTS) {
+                    checkAborted();
+                    sched_yield();
+                }
+                unsigned long long head = ticket;
+                char* slot = slots + (head % RING_SLOTS) * slot_bytes;
+                int dims[2] = {block.rows, block.cols};
+                std::memcpy(slot, dims, sizeof(dims));
+                std::memcpy(slot + sizeof(dims), block.matrix.data(), block.matrix.size() * sizeof(int));
+                header->head.store(head + 1, std::memory_order_release);
+            }
+
+            Mat receive() {
+                while (header->tail.load(std::memory_order_relaxed) ==
+                       header->head.load(std::memory_order_acquire)) {
+                    checkAborted();
+                    sched_yield();
+                }
+                unsigned long long tail = header->tail.load(std::memory_order_relaxed);
+                const char* slot = slots + (tail % RING_SLOTS) * slot_bytes;
+                int dims[2];
+                std::memcpy(dims, slot, sizeof(dims));
+                Mat block(dims[0], dims[1]);
+                std::memcpy(block.matrix.data(), slot + sizeof(dims), block.matrix.size() * sizeof(int));
+                header->tail.store(tail + 1, std::memory_order_release);
+                return block;
+            }
+        };
+
+        struct WorkerStats {
+            double compute_us;
+            double comm_us;
+            long long bytes_sent;
+            int done;
+        };
+
+        // Split n into q nearly equal parts; part p is [bound(n, q, p), bound(n, q, p + 1))
+        int bound(int n, int q, int p) { return static_cast<int>(static_cast<long long>(n) * p / q); }
+
+        Mat copyBlock(MatView mat, int r0, int r1, int c0, int c1) {
+            Mat block(r1 - r0, c1 - c0);
+            for (int i = r0; i < r1; i++) {
+                std::copy(mat.matrix + size_t(i) * mat.cols + c0, mat.matrix + size_t(i) * mat.cols + c1,
+                          block.matrix.begin() + (i - r0) * block.cols);
+            }
+            return block;
+        }
+
+        // POSIX shared memory segment, unlinked right after mapping so nothing outlives the run
+        void* mapShared(size_t bytes) {
+            static std::atomic<int> counter{0};
+            std::string name = "/matmul_summa_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+            int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd < 0) throw std::runtime_error("shm_open failed for " + name);
+            shm_unlink(name.c_str());
+            if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+                close(fd);
+                throw std::runtime_error("ftruncate failed on shared memory segment");
+            }
+            void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (base == MAP_FAILED) throw std::runtime_error("mmap failed on shared memory segment");
+            return base;
+        }
+    }
+
+    // Multiply on a q x q grid of forked worker processes, q = floor(sqrt(processes))
+    Mat SummaMul(MatView mat1, MatView mat2, int processes, SummaStats* stats = nullptr) {
+        using namespace summa;
+        if (mat1.cols != mat2.rows) throw std::invalid_argument("operand shapes do not match");
+        int q = 1;
+        while ((q + 1) * (q + 1) <= processes) q++;
+        int workers = q * q;
+
+        // Largest block either operand can produce, plus the dimension prefix
+        size_t max_block = 0;
+        for (int p = 0; p < q; p++) {
+            for (int s = 0; s < q; s++) {
+                size_t a = size_t(bound(mat1.rows, q, p + 1) - bound(mat1.rows, q, p)) *
+                           (bound(mat1.cols, q, s + 1) - bound(mat1.cols, q, s));
+                size_t b = size_t(bound(mat2.rows, q, p + 1) - bound(mat2.rows, q, p)) *
+                           (bound(mat2.cols, q, s + 1) - bound(mat2.cols, q, s));
+                max_block = (std::max)(max_block, (std::max)(a, b));
+            }
+        }
+        size_t slot_bytes = (2 * sizeof(int) + max_block * sizeof(int) + 63) / 64 * 64;
+        size_t ring_bytes = 64 + RING_SLOTS * slot_bytes;
+
+        // Every worker has one inbox ring for A panels (from its grid row) and one for B panels (from its column)
+        size_t rings_per_worker = 2;
+        size_t result_bytes = size_t(mat1.rows) * mat2.cols * sizeof(int);
+        size_t control_offset = (result_bytes + 63) / 64 * 64;
+        size_t stats_offset = control_offset + 64;
+        size_t rings_offset = stats_offset + (workers * sizeof(WorkerStats) + 63) / 64 * 64;
+        size_t total_bytes = rings_offset + workers * rings_per_worker * ring_bytes;
+
+        char* base = static_cast<char*>(mapShared(total_bytes));
+        int* shared_result = reinterpret_cast<int*>(base);
+        auto* worker_stats = reinterpret_cast<WorkerStats*>(base + stats_offset);
+        std::memset(base, 0, rings_offset);
+        auto* aborted = new (base + control_offset) std::atomic<int>(0);
+
+        auto ring = [&](int receiver, int index) {
+            char* at = base + rings_offset + (receiver * rings_per_worker + index) * ring_bytes;
+            return Ring{reinterpret_cast<RingHeader*>(at), at + 64, slot_bytes, aborted};
+        };
+        for (int w = 0; w < workers; w++) {
+            for (size_t index = 0; index < rings_per_worker; index++) {
+                RingHeader* header = ring(w, static_cast<int>(index)).header;
+                new (&header->head) std::atomic<unsigned long long>(0);
+                new (&header->tail) std::atomic<unsigned long long>(0);
+            }
+        }
+        auto a_ring = [&](int r, int c) { return ring(r * q + c, 0); };
+        auto b_ring = [&](int r, int c) { return ring(r * q + c, 1); };
+        // A receiver gets no message at the step where it owns the panel itself
+        auto ticket = [](int step, int receiver_index) {
+            return static_cast<unsigned long long>(step > receiver_index ? step - 1 : step);
+        };
+
+        // Stops every worker still running: they see the flag in their ring loops, or are killed
+        auto abortWorkers = [&](const std::vector<pid_t>& running) {
+            aborted->store(1, std::memory_order_relaxed);
+            for (pid_t child : running) kill(child, SIGKILL);
+        };
+
+        std::vector<pid_t> children;
+        for (int w = 0; w < workers; w++) {
+            pid_t pid = fork();
+            if (pid < 0) {
+                abortWorkers(children);
+                for (pid_t child : children) waitpid(child, nullptr, 0);
+                munmap(base, total_bytes);
+                throw std::runtime_error("fork failed");
+            }
+            if (pid > 0) { children.push_back(pid); continue; }
+
+            // Worker process: private copies of the owned blocks. Nothing may unwind past here
+            // into the caller's stack frames, copied by fork: any failure ends the process.
+            try {
+                int r = w / q, c = w % q;
+                int row0 = bound(mat1.rows, q, r), row1 = bound(mat1.rows, q, r + 1);
+                int col0 = bound(mat2.cols, q, c), col1 = bound(mat2.cols, q, c + 1);
+                Mat own_a = copyBlock(mat1, row0, row1, bound(mat1.cols, q, c), bound(mat1.cols, q, c + 1));
+                Mat own_b = copyBlock(mat2, bound(mat2.rows, q, r), bound(mat2.rows, q, r + 1), col0, col1);
+                Mat own_c(row1 - row0, col1 - col0);
+
+                double compute_us = 0, comm_us = 0;
+                long long bytes_sent = 0;
+                auto now = [] { return std::chrono::steady_clock::now(); };
+                auto us = [](auto d) { return std::chrono::duration<double, std::micro>(d).count(); };
+
+                for (int s = 0; s < q; s++) {
+                    auto t0 = now();
+                    if (c == s) {
+                        for (int peer = 0; peer < q; peer++) {
+                            if (peer == c) continue;
+                            a_ring(r, peer).send(own_a, ticket(s, peer));
+                            bytes_sent += own_a.matrix.size() * sizeof(int);
+                        }
+                    }
+                    if (r == s) {
+                        for (int peer = 0; peer < q; peer++) {
+                            if (peer == r) continue;
+                            b_ring(peer, c).send(own_b, ticket(s, peer));
+                            bytes_sent += own_b.matrix.size() * sizeof(int);
+                        }
+                    }
+                    Mat received_a(0, 0), received_b(0, 0);
+                    if (c != s) received_a = a_ring(r, c).receive();
+                    if (r != s) received_b = b_ring(r, c).receive();
+                    const Mat& panel_a = c == s ? own_a : received_a;
+                    const Mat& panel_b = r == s ? own_b : received_b;
+                    auto t1 = now();
+
+                    Mat product = BlockedMul(panel_a, panel_b);
+                    for (size_t idx = 0; idx < product.matrix.size(); idx++) own_c.matrix[idx] += product.matrix[idx];
+                    auto t2 = now();
+
+                    comm_us += us(t1 - t0);
+                    compute_us += us(t2 - t1);
+                }
+
+                for (int i = 0; i < own_c.rows; i++) {
+                    std::memcpy(shared_result + size_t(row0 + i) * mat2.cols + col0,
+                                own_c.matrix.data() + size_t(i) * own_c.cols, own_c.cols * sizeof(int));
+                }
+                worker_stats[w] = {compute_us, comm_us, bytes_sent, 1};
+            } catch (...) {
+                aborted->store(1, std::memory_order_relaxed);
+                _exit(1);
+            }
+            _exit(0);
+        }
+
+        // Reap the workers as they finish; the first failure aborts the others, which would
+        // otherwise wait forever for its panels
+        bool failed = false;
+        std::vector<pid_t> running = children;
+        while (!running.empty()) {
+            bool reaped = false;
+            for (size_t n = 0; n < running.size();) {
+                int status = 0;
+                pid_t done = waitpid(running[n], &status, WNOHANG);
+                if (done == 0) { n++; continue; }
+                reaped = true;
+                running.erase(running.begin() + n);
+                if (!failed && (done < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+                    failed = true;
+                    abortWorkers(running);
+                }
+            }
+            if (!reaped) std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+
+        Mat result(mat1.rows, mat2.cols);
+        std::memcpy(result.matrix.data(), shared_result, result_bytes);
+
+        SummaStats summary;
+        summary.grid = q;
+        for (int w = 0; w < workers; w++) {
+            const WorkerStats& ws = worker_stats[w];
+            if (!ws.done) failed = true;
+            summary.compute_us_avg += ws.compute_us / workers;
+            summary.comm_us_avg += ws.comm_us / workers;
+            summary.compute_us_max = (std::max)(summary.compute_us_max, ws.compute_us);
+            summary.comm_us_max = (std::max)(summary.comm_us_max, ws.comm_us);
+            summary.bytes_sent += ws.bytes_sent;
+        }
+        munmap(base, total_bytes);
+
+        if (failed) throw std::runtime_error("SUMMA worker process failed");
+        if (stats) *stats = summary;
+        return result;
+    }
+
+}
+
+#endif
@@ -0,0 +1,130 @@
+#pragma once
+
+// Symmetric rank-k update C = A * A^T computing only the lower triangle.
+// C[i, j] is the dot product of rows i and j of A, both contiguous, so no transposed copy is
+// needed by the blocked kernels. Only tiles with tj <= ti are computed, and diagonal tiles stop
+// at the diagonal; mirrorLower fills the upper triangle afterwards when a full matrix is wanted.
+
+#include <atomic>
+#include <vector>
+#include "Rec_MatMul.h"
+
+namespace MatMath {
+
+    // C[i0:i1, j0:j1] = add(C, A[i0:i1, k0:k1] * A[j0:j1, k0:k1]^T), only entries with j <= i
+    template <class S = PlusTimes>
+    void SyrkTile(MatView mat, Mat& result, int i0, int i1, int j0, int j1, int k0, int k1) {
+        using Acc = Semiring::Accumulator<S>;
+        for (int ii = i0; ii < i1; ii++) {
+            const int* a_row = mat.matrix + size_t(ii) * mat.cols;
+            int j_end = (std::min)(j1, ii + 1);
+            for (int jj = j0; jj < j_end; jj++) {
+                const int* b_row = mat.matrix + size_t(jj) * mat.cols;
+                typename Acc::type sum = Acc::zero();
+                for (int kk = k0; kk < k1; kk++) sum = Acc::step(sum, a_row[kk], b_row[kk]);
+                int& c = result.matrix[size_t(ii) * result.cols + jj];
+                c = S::add(c, Acc::finish(sum));
+            }
+        }
+    }
+
+    // Copy the lower triangle onto the upper one, tile by tile so both sides stay in cache
+    void mirrorLower(Mat& result, const ThreadConfig& config = {}) {
+        const int T = 64;
+        int tiles = (result.rows + T - 1) / T;
+        std::atomic<int> next_row{0};
+        runWorkers(config, [&](int) {
+            for (int ti = next_row++; ti < tiles; ti = next_row++) {
+                for (int tj = 0; tj <= ti; tj++) {
+                    int i_end = (std::min)((ti + 1) * T, result.rows);
+                    for (int i = ti * T; i < i_end; i++) {
+                        int j_end = (std::min)((tj + 1) * T, i);
+                        for (int j = tj * T; j < j_end; j++) {
+                            result.matrix[size_t(j) * result.cols + i] = result.matrix[size_t(i) * result.cols + j];
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    template <class S = PlusTimes>
+    Mat SyrkBlocked(MatView mat, bool mirror = true) {
+        Mat result = semiringZeros<S>(mat.rows, mat.rows);
+        for (int i = 0; i < mat.rows; i += BLOCK_SIZE) {
+            for (int j = 0; j <= i; j += BLOCK_SIZE) {
+                for (int k = 0; k < mat.cols; k += BLOCK_SIZE) {
+                    SyrkTile<S>(mat, result,
+                                i, (std::min)(i + BLOCK_SIZE, mat.rows),
+                                j, (std::min)(j + BLOCK_SIZE, mat.rows),
+                                k, (std::min)(k + BLOCK_SIZE, mat.cols));
+                }
+            }
+        }
+        if (mirror) mirrorLower(result, SINGLE_THREAD);
+        return result;
+    }
+
+    // Lower-triangle tiles shared out across the workers. Off-diagonal tiles come first and the
+    // half-cost diagonal tiles last, so the tail of the schedule is the cheap work. Writes into an
+    // existing rows x rows buffer, whose previous contents are discarded.
+    template <class S = PlusTimes>
+    void SyrkBlocked_threading(MatView mat, Mat& result, int BLOCK_SIZE, const ThreadConfig& config = {}, bool mirror = true) {
+        // A^T covers the same memory as A, so this checks both the rows x rows shape and aliasing
+        checkResult(mat, MatView(mat.cols, mat.rows, mat.matrix), result);
+        std::fill(result.matrix.begin(), result.matrix.end(), S::zero());
+        int tiles = (mat.rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        std::vector<std::pair<int, int>> tasks;
+        for (int tj = 0; tj < tiles; tj++)
+            for (int ti = tj + 1; ti < tiles; ti++) tasks.push_back({ti, tj});
+        for (int t = 0; t < tiles; t++) tasks.push_back({t, t});
+
+        std::atomic<size_t> next_task{0};
+        runWorkers(config, [&](int) {
+            for (size_t n = next_task++; n < tasks.size(); n = next_task++) {
+                int i = tasks[n].first * BLOCK_SIZE, j = tasks[n].second * BLOCK_SIZE;
+                for (int k = 0; k < mat.cols; k += BLOCK_SIZE) {
+                    SyrkTile<S>(mat, result,
+                                i, (std::min)(i + BLOCK_SIZE, mat.rows),
+                                j, (std::min)(j + BLOCK_SIZE, mat.rows),
+                                k, (std::min)(k + BLOCK_SIZE, mat.cols));
+                }
+            }
+        });
+        if (mirror) mirrorLower(result, config);
+    }
+
+    template <class S = PlusTimes>
+    Mat SyrkBlocked_threading(MatView mat, int BLOCK_SIZE, const ThreadConfig& config = {}, bool mirror = true) {
+        Mat result(mat.rows, mat.rows);
+        SyrkBlocked_threading<S>(mat, result, BLOCK_SIZE, config, mirror);
+        return result;
+    }
+
+    // Recursive lower triangle of rows [r0, r1): halve the rows, recurse on the two diagonal
+    // blocks and compute the off-diagonal block C21 = A2 * A1^T with matMul's quadrant recursion
+    // against the transposed operand
+    template <class S = PlusTimes>
+    void syrkRec(Mat& result, MatView mat, MatView transposed, int r0, int r1) {
+        if (r1 - r0 <= 64) {
+            SyrkTile<S>(mat, result, r0, r1, r0, r1, 0, mat.cols);
+            return;
+        }
+        int mid = r0 + (r1 - r0) / 2;
+        syrkRec<S>(result, mat, transposed, r0, mid);
+        syrkRec<S>(result, mat, transposed, mid, r1);
+        matMul<S>(result, mat, transposed, mid, r1, 0, mat.cols, 0, mat.cols, r0, mid, mid, r0);
+    }
+
+    template <class S = PlusTimes>
+    Mat syrkRec(MatView mat, bool mirror = true) {
+        Mat result = semiringZeros<S>(mat.rows, mat.rows);
+        Mat transposed(mat.cols, mat.rows);
+        for (int i = 0; i < mat.rows; i++)
+            for (int k = 0; k < mat.cols; k++) transposed.matrix[size_t(k) * mat.rows + i] = mat.matrix[size_t(i) * mat.cols + k];
+        syrkRec<S>(result, mat, transposed, 0, mat.rows);
+        if (mirror) mirrorLower(result, SINGLE_THREAD);
+        return result;
+    }
+
+}
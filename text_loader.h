@@ -0,0 +1,251 @@
+#pragma once
+
+// Parallel loader for Matrix Market (.mtx) and CSV text matrices.
+// The file is mapped, split into one chunk per worker at newline boundaries and parsed with
+// std::from_chars straight into a preallocated Mat. Formats whose values are positional
+// (CSV rows, Matrix Market "array" columns) first count records per chunk in parallel so
+// every chunk knows where its first value belongs.
+
+#include <cctype>
+#include <charconv>
+#include <exception>
+#include <mutex>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "Rec_MatMul.h"
+#include "mapped_file.h"
+
+enum class TextMatrixFormat { Csv, MatrixMarketArray, MatrixMarketCoordinate };
+
+struct TextMatrixInfo {
+    TextMatrixFormat format = TextMatrixFormat::Csv;
+    int rows = 0, cols = 0;
+    long long entries = 0;     // coordinate entries listed in the file
+    bool symmetric = false;    // coordinate only: mirror (i, j) to (j, i)
+    bool pattern = false;      // coordinate only: entries carry no value, read as 1
+    size_t data_offset = 0;    // first byte after the header / size line
+};
+
+namespace textio {
+
+    bool isBlank(const char* p, const char* end) {
+        for (; p < end; p++) {
+            if (*p != ' ' && *p != '\t' && *p != '\r') return false;
+        }
+        return true;
+    }
+
+    const char* lineEnd(const char* p, const char* end) {
+        while (p < end && *p != '\n') p++;
+        return p;
+    }
+
+    // Skip separators (whitespace, ',' or ';') and parse one number; returns false at end of line.
+    // Integers go through the integer from_chars; decimals and exponents are rounded to the nearest int.
+    bool nextNumber(const char*& p, const char* end, int& value) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',' || *p == ';' || *p == '\r')) p++;
+        if (p >= end) return false;
+        if (*p == '+') p++;
+        long long whole = 0;
+        auto [next, ec] = std::from_chars(p, end, whole);
+        if (ec != std::errc() || (next < end && (*next == '.' || *next == 'e' || *next == 'E'))) {
+            double real = 0;
+            auto [real_next, real_ec] = std::from_chars(p, end, real);
+            if (real_ec != std::errc()) throw std::runtime_error("malformed number in text matrix");
+            value = static_cast<int>(std::llround(real));
+            p = real_next;
+        } else {
+            value = static_cast<int>(whole);
+            p = next;
+        }
+        return true;
+    }
+
+    // A record is a non-blank line that is not a '%' comment
+    bool isRecord(const char* p, const char* e) { return !isBlank(p, e) && *p != '%'; }
+
+    // [begin, end) byte ranges of `parts` chunks of the data section, each starting at a line start
+    std::vector<std::pair<size_t, size_t>> splitLines(const char* data, size_t begin, size_t end, int parts) {
+        std::vector<size_t> cuts{begin};
+        for (int t = 1; t < parts; t++) {
+            size_t cut = (std::max)(cuts.back(), begin + (end - begin) * t / parts);
+            while (cut < end && cut > begin && data[cut - 1] != '\n') cut++;
+            cuts.push_back(cut);
+        }
+        cuts.push_back(end);
+        std::vector<std::pair<size_t, size_t>> chunks;
+        for (size_t c = 0; c + 1 < cuts.size(); c++) chunks.push_back({cuts[c], cuts[c + 1]});
+        return chunks;
+    }
+
+    // Number of records in each chunk, counted in parallel; returns the exclusive prefix sums
+    std::vector<long long> recordOffsets(const char* data, const std::vector<std::pair<size_t, size_t>>& chunks,
+                                         const ThreadConfig& config) {
+        std::vector<long long> counts(chunks.size() + 1, 0);
+        MatMath::runWorkers(config, [&](int t) {
+            if (t >= static_cast<int>(chunks.size())) return;
+            const char* p = data + chunks[t].first;
+            const char* end = data + chunks[t].second;
+            long long count = 0;
+            while (p < end) {
+                const char* e = lineEnd(p, end);
+                if (isRecord(p, e)) count++;
+                p = e + 1;
+            }
+            counts[t + 1] = count;
+        });
+        for (size_t c = 1; c < counts.size(); c++) counts[c] += counts[c - 1];
+        return counts;
+    }
+}
+
+bool isTextMatrixFile(const std::string& path) {
+    auto ends_with = [&](const std::string& suffix) {
+        return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return ends_with(".mtx") || ends_with(".csv") || ends_with(".txt");
+}
+
+// Parse the header (Matrix Market banner and size line, or CSV shape from its first row)
+TextMatrixInfo readTextMatrixInfo(const MappedFile& file) {
+    using namespace textio;
+    TextMatrixInfo info;
+    const char* data = file.data();
+    const char* end = data + file.size();
+    const char* p = data;
+
+    std::string banner = "%%MatrixMarket";
+    if (file.size() >= banner.size() && std::string(data, banner.size()) == banner) {
+        const char* e = lineEnd(p, end);
+        std::string header(p, e);
+        for (char& ch : header) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        if (header.find("coordinate") != std::string::npos) info.format = TextMatrixFormat::MatrixMarketCoordinate;
+        else if (header.find("array") != std::string::npos) info.format = TextMatrixFormat::MatrixMarketArray;
+        else throw std::runtime_error("unsupported Matrix Market banner: " + header);
+        if (header.find("complex") != std::string::npos) throw std::runtime_error("complex Matrix Market files are not supported");
+        info.pattern = header.find("pattern") != std::string::npos;
+        info.symmetric = header.find("symmetric") != std::string::npos;
+        if (info.format == TextMatrixFormat::MatrixMarketArray && header.find("general") == std::string::npos) {
+            throw std::runtime_error("only general Matrix Market arrays are supported");
+        }
+        p = e + 1;
+        while (p < end) {
+            e = lineEnd(p, end);
+            if (isRecord(p, e)) break;
+            p = e + 1;
+        }
+        e = lineEnd(p, end);
+        const char* q = p;
+        int rows = 0, cols = 0, entries = 0;
+        if (!nextNumber(q, e, rows) || !nextNumber(q, e, cols)) throw std::runtime_error("missing Matrix Market size line");
+        if (info.format == TextMatrixFormat::MatrixMarketCoordinate && !nextNumber(q, e, entries)) {
+            throw std::runtime_error("missing Matrix Market entry count");
+        }
+        info.rows = rows;
+        info.cols = cols;
+        info.entries = entries;
+        info.data_offset = (std::min)(static_cast<size_t>(e - data) + 1, file.size());
+        return info;
+    }
+
+    // CSV: skip a leading header row if it is not numeric, take the width from the first record
+    info.format = TextMatrixFormat::Csv;
+    while (p < end && isBlank(p, lineEnd(p, end))) p = lineEnd(p, end) + 1;
+    const char* e = lineEnd(p, end);
+    const char* first = p;
+    while (first < e && (*first == ' ' || *first == '\t')) first++;
+    if (first < e && !(std::isdigit(static_cast<unsigned char>(*first)) || *first == '-' || *first == '+' || *first == '.')) {
+        p = (std::min)(e + 1, end);
+        e = lineEnd(p, end);
+    }
+    info.data_offset = static_cast<size_t>(p - data);
+    int value;
+    const char* q = p;
+    while (nextNumber(q, e, value)) info.cols++;
+    return info;
+}
+
+// Parse into `into`, which must already have the file's shape
+void loadTextMatrix(const MappedFile& file, const TextMatrixInfo& info, Mat& into, const ThreadConfig& config = {}) {
+    using namespace textio;
+    if (into.rows != info.rows || into.cols != info.cols) throw std::invalid_argument("destination shape mismatch");
+    const char* data = file.data();
+    auto chunks = splitLines(data, info.data_offset, file.size(), resolveThreadCount(config));
+    std::vector<long long> first_record;
+    if (info.format != TextMatrixFormat::MatrixMarketCoordinate) first_record = recordOffsets(data, chunks, config);
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    MatMath::runWorkers(config, [&](int t) {
+        if (t >= static_cast<int>(chunks.size())) return;
+        try {
+            const char* p = data + chunks[t].first;
+            const char* end = data + chunks[t].second;
+            long long record = first_record.empty() ? 0 : first_record[t];
+            int value;
+            while (p < end) {
+                const char* e = lineEnd(p, end);
+                if (isRecord(p, e)) {
+                    const char* q = p;
+                    if (info.format == TextMatrixFormat::Csv) {
+                        if (record >= into.rows) throw std::runtime_error("CSV has more rows than expected");
+                        int* row = into.matrix.data() + size_t(record) * into.cols;
+                        for (int j = 0; j < into.cols && nextNumber(q, e, value); j++) row[j] = value;
+                    } else if (info.format == TextMatrixFormat::MatrixMarketArray) {
+                        // Column-major, one value per record
+                        if (nextNumber(q, e, value) && record < static_cast<long long>(into.rows) * into.cols) {
+                            into.matrix[size_t(record % into.rows) * into.cols + size_t(record / into.rows)] = value;
+                        }
+                    } else {
+                        int i = 0, j = 0;
+                        value = 1;
+                        if (!nextNumber(q, e, i) || !nextNumber(q, e, j)) throw std::runtime_error("malformed Matrix Market entry");
+                        if (!info.pattern) nextNumber(q, e, value);
+                        if (i < 1 || i > into.rows || j < 1 || j > into.cols) throw std::runtime_error("Matrix Market entry out of range");
+                        // Entries are distinct positions, so workers never write the same element
+                        into.matrix[size_t(i - 1) * into.cols + (j - 1)] = value;
+                        if (info.symmetric && i != j) into.matrix[size_t(j - 1) * into.cols + (i - 1)] = value;
+                    }
+                    record++;
+                }
+                p = e + 1;
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+        }
+    });
+    if (error) std::rethrow_exception(error);
+}
+
+Mat loadTextMatrix(const std::string& path, const ThreadConfig& config = {}) {
+    MappedFile file(path, false);
+    TextMatrixInfo info = readTextMatrixInfo(file);
+    if (info.format == TextMatrixFormat::Csv) {
+        auto chunks = textio::splitLines(file.data(), info.data_offset, file.size(), resolveThreadCount(config));
+        info.rows = static_cast<int>(textio::recordOffsets(file.data(), chunks, config).back());
+    }
+    Mat mat(info.rows, info.cols);
+    if (file.size() > 0) loadTextMatrix(file, info, mat, config);
+    return mat;
+}
+
+void writeCsv(const std::string& path, MatView mat) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) throw std::runtime_error("cannot create " + path);
+    std::string line;
+    char buffer[16];
+    for (int i = 0; i < mat.rows; i++) {
+        line.clear();
+        for (int j = 0; j < mat.cols; j++) {
+            if (j) line += ',';
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), mat.matrix[size_t(i) * mat.cols + j]);
+            line.append(buffer, end);
+        }
+        line += '\n';
+        file << line;
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include "Rec_MatMul.h"
+
+namespace MatMath {
+
+    // One (i, j, k) step of the blocked algorithm: C(i, j) += A(i, k) * B(k, j), in tile units
+    struct TileTask {
+        int i, j, k;
+    };
+
+    // DAG of tile tasks. Steps that update the same C tile form a chain ordered by k;
+    // chains of different C tiles are independent.
+    class TileTaskGraph {
+    public:
+        TileTaskGraph(int row_tiles, int col_tiles, int k_blocks)
+            : row_tiles_(row_tiles), col_tiles_(col_tiles), k_blocks_(k_blocks) {}
+
+        int size() const { return row_tiles_ * col_tiles_ * k_blocks_; }
+
+        // Tasks with no predecessor: the first k step of every C tile
+        std::vector<TileTask> roots() const {
+            std::vector<TileTask> tasks;
+            if (k_blocks_ == 0) return tasks;
+            for (int j = 0; j < col_tiles_; j++)
+                for (int i = 0; i < row_tiles_; i++)
+                    tasks.push_back({i, j, 0});
+            return tasks;
+        }
+
+        // The task unblocked by completing t, if any
+        bool successor(const TileTask& t, TileTask& next) const {
+            if (t.k + 1 >= k_blocks_) return false;
+            next = {t.i, t.j, t.k + 1};
+            return true;
+        }
+
+    private:
+        int row_tiles_, col_tiles_, k_blocks_;
+    };
+
+    // How much of a candidate's working set the worker that just ran `last` still has in cache
+    int cacheAffinity(const TileTask& last, const TileTask& candidate) {
+        int score = 0;
+        if (candidate.i == last.i && candidate.j == last.j) score += 4;  // C tile
+        if (candidate.k == last.k && candidate.j == last.j) score += 2;  // B panel
+        if (candidate.i == last.i && candidate.k == last.k) score += 1;  // A panel
+        return score;
+    }
+
+    // Blocked multiply executed as a DAG of tile tasks by a dynamic scheduler.
+    // Workers take any ready task, preferring the one sharing most data with their previous task.
+    // A completed task's successor goes to the front of the ready list, where the scan window
+    // always sees it (the worker that ran its predecessor still holds that C tile); roots wait
+    // behind in order. Ties go to the task nearest the front.
+    Mat BlockedMul_taskgraph(MatView mat1, MatView mat2, int BLOCK_SIZE, const ThreadConfig& config = {}) {
+        Mat result(mat1.rows, mat2.cols);
+        TileTaskGraph graph((mat1.rows + BLOCK_SIZE - 1) / BLOCK_SIZE,
+                            (mat2.cols + BLOCK_SIZE - 1) / BLOCK_SIZE,
+                            (mat1.cols + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+        std::mutex mutex;
+        std::condition_variable ready_cv;
+        std::vector<TileTask> roots = graph.roots();
+        std::deque<TileTask> ready(roots.begin(), roots.end());
+        int remaining = graph.size();
+        const size_t scan_window = 64; // picks scan and erase within the first 64 tasks: O(1) on huge graphs
+
+        runWorkers(config, [&](int) {
+            TileTask last{-1, -1, -1};
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                ready_cv.wait(lock, [&] { return !ready.empty() || remaining == 0; });
+                if (remaining == 0) break;
+
+                size_t best = 0;
+                int best_score = -1;
+                for (size_t n = 0; n < ready.size() && n < scan_window; n++) {
+                    int score = cacheAffinity(last, ready[n]);
+                    if (score > best_score) { best = n; best_score = score; }
+                }
+                TileTask task = ready[best];
+                ready.erase(ready.begin() + best);
+                lock.unlock();
+
+                int k_start = task.k * BLOCK_SIZE;
+                BlockedMul_tile(mat1, mat2, result, BLOCK_SIZE, task.i * BLOCK_SIZE, task.j * BLOCK_SIZE,
+                                k_start, (std::min)(k_start + BLOCK_SIZE, mat1.cols));
+                last = task;
+
+                lock.lock();
+                remaining--;
+                TileTask next;
+                if (graph.successor(task, next)) {
+                    ready.push_front(next);
+                    ready_cv.notify_one();
+                }
+                if (remaining == 0) ready_cv.notify_all();
+            }
+        });
+        return result;
+    }
+
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+// Transposes and the op(A) * op(B) multiply.
+// transpose / transposeInPlace are cache-oblivious: they halve the longer side until a tile is
+// small enough for its rows and columns to sit in L1 together, whatever the cache sizes are.
+// transposeBlocked is the fixed-tile version they are compared against.
+// BlockedMul_op reads transposed operands in their stored order instead of materializing the
+// transpose: for A * B^T every C entry is a dot product of two contiguous rows.
+
+#include <atomic>
+#include <vector>
+#include "Rec_MatMul.h"
+
+enum class Op { N, T };
+
+namespace MatMath {
+
+    const int TRANSPOSE_BASE = 32;
+
+    // dst[c, r] = src[r, c] for r in [r0, r1), c in [c0, c1); splits the longer side
+    void transposeRec(const int* src, int src_stride, int* dst, int dst_stride, int r0, int r1, int c0, int c1) {
+        if (r1 - r0 <= TRANSPOSE_BASE && c1 - c0 <= TRANSPOSE_BASE) {
+            for (int r = r0; r < r1; r++)
+                for (int c = c0; c < c1; c++) dst[size_t(c) * dst_stride + r] = src[size_t(r) * src_stride + c];
+            return;
+        }
+        if (r1 - r0 >= c1 - c0) {
+            int mid = r0 + (r1 - r0) / 2;
+            transposeRec(src, src_stride, dst, dst_stride, r0, mid, c0, c1);
+            transposeRec(src, src_stride, dst, dst_stride, mid, r1, c0, c1);
+        } else {
+            int mid = c0 + (c1 - c0) / 2;
+            transposeRec(src, src_stride, dst, dst_stride, r0, r1, c0, mid);
+            transposeRec(src, src_stride, dst, dst_stride, r0, r1, mid, c1);
+        }
+    }
+
+    Mat transpose(MatView mat) {
+        Mat result(mat.cols, mat.rows);
+        transposeRec(mat.matrix, mat.cols, result.matrix.data(), result.cols, 0, mat.rows, 0, mat.cols);
+        return result;
+    }
+
+    Mat transposeBlocked(MatView mat, int block = TRANSPOSE_BASE) {
+        Mat result(mat.cols, mat.rows);
+        for (int r0 = 0; r0 < mat.rows; r0 += block) {
+            for (int c0 = 0; c0 < mat.cols; c0 += block) {
+                int r1 = (std::min)(r0 + block, mat.rows), c1 = (std::min)(c0 + block, mat.cols);
+                for (int r = r0; r < r1; r++)
+                    for (int c = c0; c < c1; c++) result.matrix[size_t(c) * result.cols + r] = mat.matrix[size_t(r) * mat.cols + c];
+            }
+        }
+        return result;
+    }
+
+    // Square in-place: swap block [r0, r1) x [c0, c1) with its mirror, recursing on quadrants.
+    // On the diagonal (r0 == c0) only the lower half and the diagonal blocks are visited.
+    void transposeSwapRec(int* data, int stride, int r0, int r1, int c0, int c1) {
+        if (r1 - r0 <= TRANSPOSE_BASE && c1 - c0 <= TRANSPOSE_BASE) {
+            for (int r = r0; r < r1; r++) {
+                int c_end = r0 == c0 ? r : c1;
+                for (int c = c0; c < c_end; c++) std::swap(data[size_t(r) * stride + c], data[size_t(c) * stride + r]);
+            }
+            return;
+        }
+        int r_mid = r0 + (r1 - r0) / 2, c_mid = c0 + (c1 - c0) / 2;
+        if (r0 == c0) {
+            transposeSwapRec(data, stride, r0, r_mid, c0, c_mid);
+            transposeSwapRec(data, stride, r_mid, r1, c_mid, c1);
+            transposeSwapRec(data, stride, r_mid, r1, c0, c_mid);
+        } else if (r1 - r0 >= c1 - c0) {
+            transposeSwapRec(data, stride, r0, r_mid, c0, c1);
+            transposeSwapRec(data, stride, r_mid, r1, c0, c1);
+        } else {
+            transposeSwapRec(data, stride, r0, r1, c0, c_mid);
+            transposeSwapRec(data, stride, r0, r1, c_mid, c1);
+        }
+    }
+
+    // Square matrices swap recursively; other shapes follow the cycles of the index permutation
+    // (element at r * cols + c moves to c * rows + r) with one visited bit per element
+    void transposeInPlace(Mat& mat) {
+        if (mat.rows == mat.cols) {
+            transposeSwapRec(mat.matrix.data(), mat.cols, 0, mat.rows, 0, mat.cols);
+            return;
+        }
+        const size_t total = mat.matrix.size();
+        std::vector<bool> visited(total, false);
+        for (size_t start = 1; start + 1 < total; start++) {
+            if (visited[start]) continue;
+            size_t idx = start;
+            int carried = mat.matrix[start];
+            do {
+                size_t next = (idx % mat.cols) * mat.rows + idx / mat.cols;
+                std::swap(carried, mat.matrix[next]);
+                visited[next] = true;
+                idx = next;
+            } while (idx != start);
+        }
+        std::swap(mat.rows, mat.cols);
+    }
+
+    // C[i0:i1, j0:j1] = add(C, op(A)[i0:i1, k0:k1] * op(B)[k0:k1, j0:j1]), each pair of ops with
+    // the loop order that keeps the inner reads unit-stride
+    template <class S, Op OpA, Op OpB>
+    struct OpTileKernel : TileKernel<S> {};
+
+    // A * B^T: both operands are read along their rows
+    template <class S>
+    struct OpTileKernel<S, Op::N, Op::T> {
+        static void run(MatView mat1, MatView mat2, Mat& result, int i0, int i1, int j0, int j1, int k0, int k1) {
+            using Acc = Semiring::Accumulator<S>;
+            for (int ii = i0; ii < i1; ii++) {
+                const int* a_row = mat1.matrix + size_t(ii) * mat1.cols;
+                for (int jj = j0; jj < j1; jj++) {
+                    const int* b_row = mat2.matrix + size_t(jj) * mat2.cols;
+                    typename Acc::type sum = Acc::zero();
+                    for (int kk = k0; kk < k1; kk++) sum = Acc::step(sum, a_row[kk], b_row[kk]);
+                    int& c = result.matrix[size_t(ii) * result.cols + jj];
+                    c = S::add(c, Acc::finish(sum));
+                }
+            }
+        }
+    };
+
+    // A^T * B: k outermost, so row k of A supplies the multipliers and row k of B updates C rows
+    template <class S>
+    struct OpTileKernel<S, Op::T, Op::N> {
+        static void run(MatView mat1, MatView mat2, Mat& result, int i0, int i1, int j0, int j1, int k0, int k1) {
+            for (int kk = k0; kk < k1; kk++) {
+                const int* a_row = mat1.matrix + size_t(kk) * mat1.cols;
+                const int* b_row = mat2.matrix + size_t(kk) * mat2.cols;
+                for (int ii = i0; ii < i1; ii++) {
+                    const int a = a_row[ii];
+                    int* c_row = result.matrix.data() + size_t(ii) * result.cols;
+                    for (int jj = j0; jj < j1; jj++) c_row[jj] = S::add(c_row[jj], S::mul(a, b_row[jj]));
+                }
+            }
+        }
+    };
+
+    // A^T * B^T = (B * A)^T: column jj of C is built in a contiguous buffer from rows of A,
+    // then written out once
+    template <class S>
+    struct OpTileKernel<S, Op::T, Op::T> {
+        static void run(MatView mat1, MatView mat2, Mat& result, int i0, int i1, int j0, int j1, int k0, int k1) {
+            std::vector<int> column(i1 - i0);
+            for (int jj = j0; jj < j1; jj++) {
+                std::fill(column.begin(), column.end(), S::zero());
+                const int* b_row = mat2.matrix + size_t(jj) * mat2.cols;
+                for (int kk = k0; kk < k1; kk++) {
+                    const int b = b_row[kk];
+                    const int* a_row = mat1.matrix + size_t(kk) * mat1.cols + i0;
+                    for (int ii = 0; ii < i1 - i0; ii++) column[ii] = S::add(column[ii], S::mul(a_row[ii], b));
+                }
+                for (int ii = i0; ii < i1; ii++) {
+                    int& c = result.matrix[size_t(ii) * result.cols + jj];
+                    c = S::add(c, column[ii - i0]);
+                }
+            }
+        }
+    };
+
+    // Output tiles [i, j) of op(A) * op(B) shared out across the workers
+    template <class S, Op OpA, Op OpB>
+    void BlockedMul_op_tiles(MatView mat1, MatView mat2, Mat& result, int k_size, const ThreadConfig& config) {
+        int row_tiles = (result.rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        int col_tiles = (result.cols + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        std::atomic<int> next_tile{0};
+        runWorkers(config, [&](int) {
+            for (int tile = next_tile++; tile < row_tiles * col_tiles; tile = next_tile++) {
+                int i = (tile % row_tiles) * BLOCK_SIZE, j = (tile / row_tiles) * BLOCK_SIZE;
+                for (int k = 0; k < k_size; k += BLOCK_SIZE) {
+                    OpTileKernel<S, OpA, OpB>::run(mat1, mat2, result,
+                                                   i, (std::min)(i + BLOCK_SIZE, result.rows),
+                                                   j, (std::min)(j + BLOCK_SIZE, result.cols),
+                                                   k, (std::min)(k + BLOCK_SIZE, k_size));
+                }
+            }
+        });
+    }
+
+    // C = op(A) * op(B), where op(X) is X or X^T as stored
+    template <class S = PlusTimes>
+    Mat BlockedMul_op(MatView mat1, Op op1, MatView mat2, Op op2, const ThreadConfig& config = SINGLE_THREAD) {
+        int m = op1 == Op::N ? mat1.rows : mat1.cols;
+        int k = op1 == Op::N ? mat1.cols : mat1.rows;
+        int n = op2 == Op::N ? mat2.cols : mat2.rows;
+        if (k != (op2 == Op::N ? mat2.rows : mat2.cols)) throw std::invalid_argument("operand shapes do not match");
+        Mat result = semiringZeros<S>(m, n);
+        if (op1 == Op::N && op2 == Op::N) BlockedMul_op_tiles<S, Op::N, Op::N>(mat1, mat2, result, k, config);
+        else if (op1 == Op::N) BlockedMul_op_tiles<S, Op::N, Op::T>(mat1, mat2, result, k, config);
+        else if (op2 == Op::N) BlockedMul_op_tiles<S, Op::T, Op::N>(mat1, mat2, result, k, config);
+        else BlockedMul_op_tiles<S, Op::T, Op::T>(mat1, mat2, result, k, config);
+        return result;
+    }
+
+    template <class S = PlusTimes>
+    Mat BlockedMul_threading_op(MatView mat1, Op op1, MatView mat2, Op op2, const ThreadConfig& config = {}) {
+        return BlockedMul_op<S>(mat1, op1, mat2, op2, config);
+    }
+
+}
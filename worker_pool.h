@@ -0,0 +1,126 @@
+#pragma once
+
+// Worker threads that outlive a single multiply.
+// WorkerPool keeps thread_count threads, placed once by the affinity plan, parked on a condition
+// variable between calls; run() hands every thread the same worker function and waits for all of
+// them, so a threaded kernel pays a wake-up instead of a thread start and join per call.
+// sharedWorkerPool() keeps one pool per (affinity policy, thread count, CPU list) for the life of
+// the process; runWorkers (Rec_MatMul.h) and MulPool (async_matmul.h) start their threads here.
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "cpu_topology.h"
+
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
+// Start thread_count threads running body(t), each placed by the affinity plan for config
+template <typename Body>
+std::vector<std::thread> startPlacedThreads(const ThreadConfig& config, int thread_count, Body body) {
+    const std::vector<int>& cpus = planAffinity(config.policy, thread_count, config.cpu_list);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; t++) {
+        threads.emplace_back([body, &cpus, cpu_list = config.cpu_list, t] {
+            placeCurrentThread(cpus, t, cpu_list);
+            body(t);
+        });
+    }
+    return threads;
+}
+
+class WorkerPool {
+public:
+    WorkerPool(const ThreadConfig& config, int thread_count) : size_(thread_count) {
+#ifndef _WIN32
+        owner_ = getpid();
+#endif
+        threads_ = startPlacedThreads(config, thread_count, [this](int t) { workerLoop(t); });
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        start_.notify_all();
+        for (auto& thread : threads_) thread.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int threads() const { return size_; }
+
+    // Runs worker(t) for every t in [0, threads()) on the pool and waits for all of them.
+    // Returns false, having run nothing, while the pool serves another call (including a nested
+    // one from its own workers) or in a child forked after the pool started, which has no threads.
+    template <typename Worker>
+    bool run(Worker& worker) {
+#ifndef _WIN32
+        if (getpid() != owner_) return false;
+#endif
+        std::unique_lock<std::mutex> busy(run_mutex_, std::try_to_lock);
+        if (!busy.owns_lock()) return false;
+        std::unique_lock<std::mutex> lock(mutex_);
+        context_ = &worker;
+        invoke_ = [](void* context, int t) { (*static_cast<Worker*>(context))(t); };
+        remaining_ = size_;
+        generation_++;
+        start_.notify_all();
+        done_.wait(lock, [&] { return remaining_ == 0; });
+        return true;
+    }
+
+private:
+    void workerLoop(int t) {
+        unsigned long long seen = 0;
+        for (;;) {
+            void* context;
+            void (*invoke)(void*, int);
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+                if (stopping_) return;
+                seen = generation_;
+                context = context_;
+                invoke = invoke_;
+            }
+            invoke(context, t);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--remaining_ == 0) done_.notify_one();
+        }
+    }
+
+    const int size_;
+    std::mutex run_mutex_;  // held by the caller for the whole of run()
+    std::mutex mutex_;
+    std::condition_variable start_, done_;
+    void* context_ = nullptr;
+    void (*invoke_)(void*, int) = nullptr;
+    unsigned long long generation_ = 0;
+    int remaining_ = 0;
+    bool stopping_ = false;
+#ifndef _WIN32
+    pid_t owner_;
+#endif
+    std::vector<std::thread> threads_;  // last, so they start once everything above is set
+};
+
+// The process-wide pool for a placement, started on first use
+WorkerPool& sharedWorkerPool(const ThreadConfig& config, int thread_count) {
+    static std::mutex mutex;
+    static std::map<std::tuple<AffinityPolicy, int, std::vector<int>>, std::unique_ptr<WorkerPool>, std::less<>> pools;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = pools.find(std::tie(config.policy, thread_count, config.cpu_list));
+    if (found == pools.end()) {
+        found = pools.emplace(std::make_tuple(config.policy, thread_count, config.cpu_list),
+                              std::make_unique<WorkerPool>(config, thread_count)).first;
+    }
+    return *found->second;
+}